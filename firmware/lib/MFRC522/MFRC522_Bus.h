@@ -0,0 +1,266 @@
+/**
+ * MFRC522_Bus.h - Bus policies for MFRC522Base<Bus>
+ *
+ * A policy moves register bytes and nothing else; the driver keeps the
+ * traffic counters. Interface:
+ *   void write(byte reg, byte count, const byte *values)  one transaction
+ *   void read(byte reg, byte count, byte *values)         one transaction
+ *   byte writeBatch(const byte *batch, byte length)       entries of
+ *        [reg][count][data...], returns the number of transactions used,
+ *        0 if the bus reported an error (the driver counts it)
+ * Register addresses are the plain 6-bit numbers (PCD_Register); each policy
+ * applies its own framing. Everything is inline so the I2C build compiles
+ * to the same code as the former hard-wired driver.
+ */
+#ifndef MFRC522_Bus_h
+#define MFRC522_Bus_h
+
+#include "MFRC522_Platform.h"
+
+#if defined(ARDUINO)
+#include <SPI.h>
+#include <Wire.h>
+#if defined(ESP32)
+#include <driver/i2c.h>
+#endif
+
+// I2C through Wire (bus started by the caller). The MFRC522 does not
+// auto-increment the register address, so a batch is one frame of
+// repeated-START writes on ESP32, separate transactions elsewhere.
+class MFRC522_I2CBus {
+   public:
+    MFRC522_I2CBus(byte address) : _address(address) {}
+
+    void write(byte reg, byte count, const byte *values) {
+        Wire.beginTransmission(_address);
+        Wire.write(reg);
+        for (byte i = 0; i < count; i++) Wire.write(values[i]);
+        Wire.endTransmission();
+    }
+
+    // Register address then repeated START + read: a single bus transaction.
+    void read(byte reg, byte count, byte *values) {
+        Wire.beginTransmission(_address);
+        Wire.write(reg);
+        Wire.endTransmission(false);
+        Wire.requestFrom(_address, count);
+        for (byte index = 0; index < count && Wire.available(); index++) {
+            values[index] = Wire.read();
+        }
+    }
+
+    byte writeBatch(const byte *batch, byte length) {
+#if defined(ESP32)
+        // Command link storage for batched writes (no heap allocation per flush).
+        static uint8_t linkBuffer[I2C_LINK_RECOMMENDED_SIZE(8)];
+        i2c_cmd_handle_t cmd = i2c_cmd_link_create_static(linkBuffer, sizeof(linkBuffer));
+        esp_err_t err = cmd ? ESP_OK : ESP_ERR_NO_MEM;
+        for (byte pos = 0; pos < length && err == ESP_OK; pos += 2 + batch[pos + 1]) {
+            err = i2c_master_start(cmd);
+            if (err == ESP_OK) err = i2c_master_write_byte(cmd, (_address << 1) | I2C_MASTER_WRITE, true);
+            if (err == ESP_OK) err = i2c_master_write_byte(cmd, batch[pos], true);
+            if (err == ESP_OK) err = i2c_master_write(cmd, &batch[pos + 2], batch[pos + 1], true);
+        }
+        if (err == ESP_OK) err = i2c_master_stop(cmd);
+        if (err != ESP_OK) {
+            // Frame did not fit the link buffer: nothing sent yet, so
+            // register-by-register writes are safe.
+            if (cmd) i2c_cmd_link_delete_static(cmd);
+            return writeEach(batch, length);
+        }
+        // A NACK may come after part of the frame was written (FIFO data,
+        // a command): not resent, the failure goes to the caller.
+        err = i2c_master_cmd_begin(I2C_NUM_0, cmd, pdMS_TO_TICKS(50));
+        i2c_cmd_link_delete_static(cmd);
+        return err == ESP_OK ? 1 : 0;
+#else
+        return writeEach(batch, length);
+#endif
+    }
+
+   private:
+    byte _address;
+
+    byte writeEach(const byte *batch, byte length) {
+        byte transactions = 0;
+        for (byte pos = 0; pos < length; pos += 2 + batch[pos + 1]) {
+            write(batch[pos], batch[pos + 1], &batch[pos + 2]);
+            transactions++;
+        }
+        return transactions;
+    }
+};
+
+// SPI (SPI.begin() by the caller). Address byte: register << 1, MSB set
+// for reads; a multi-byte read repeats the address for every byte.
+class MFRC522_SPIBus {
+   public:
+    MFRC522_SPIBus(byte chipSelectPin) : _csPin(chipSelectPin) {
+        pinMode(_csPin, OUTPUT);
+        digitalWrite(_csPin, HIGH);
+    }
+
+    void write(byte reg, byte count, const byte *values) {
+        select();
+        SPI.transfer((reg << 1) & 0x7E);
+        for (byte i = 0; i < count; i++) SPI.transfer(values[i]);
+        deselect();
+    }
+
+    void read(byte reg, byte count, byte *values) {
+        byte address = 0x80 | ((reg << 1) & 0x7E);
+        select();
+        SPI.transfer(address);
+        for (byte i = 0; i < count; i++) {
+            values[i] = SPI.transfer(i + 1 < count ? address : 0);
+        }
+        deselect();
+    }
+
+    byte writeBatch(const byte *batch, byte length) {
+        byte transactions = 0;
+        for (byte pos = 0; pos < length; pos += 2 + batch[pos + 1]) {
+            write(batch[pos], batch[pos + 1], &batch[pos + 2]);
+            transactions++;
+        }
+        return transactions;
+    }
+
+   private:
+    static const uint32_t CLOCK_HZ = 4000000;
+    byte _csPin;
+
+    void select() {
+        SPI.beginTransaction(SPISettings(CLOCK_HZ, MSBFIRST, SPI_MODE0));
+        digitalWrite(_csPin, LOW);
+    }
+    void deselect() {
+        digitalWrite(_csPin, HIGH);
+        SPI.endTransaction();
+    }
+};
+#endif
+
+// Recording fake bus for native tests: a register file with just enough
+// chip behaviour for the driver to run (FIFO, Set1-style IRQ registers,
+// SoftReset), and a log of every transaction. When a command starts
+// (CommandReg written, or StartSend in BitFramingReg) the bits of
+// irqOnCommand are raised in ComIrqReg/DivIrqReg; the default, TimerIRq
+// and CRCIRq, plays an empty field.
+class MFRC522_MockBus {
+   public:
+    static const byte LOG_SIZE = 64;
+    typedef struct { bool write; byte reg; byte count; } Transaction;
+
+    byte registers[0x40];
+    byte comIrqOnCommand;
+    byte divIrqOnCommand;
+    bool batchFails;  // writeBatch reports a bus error and writes nothing
+
+    MFRC522_MockBus() { reset(); }
+
+    void reset() {
+        memset(registers, 0, sizeof(registers));
+        comIrqOnCommand = 0x01;
+        divIrqOnCommand = 0x04;
+        batchFails = false;
+        _fifoLen = 0;
+        clearLog();
+    }
+
+    void clearLog() {
+        _transactions = 0;
+        _logLen = 0;
+    }
+
+    uint32_t transactions() const { return _transactions; }
+    byte logLength() const { return _logLen; }
+    const Transaction &logEntry(byte index) const { return _log[index]; }
+
+    // Bytes for the driver to read back from the FIFO (a tag answer).
+    void loadFifo(const byte *data, byte length) {
+        for (byte i = 0; i < length && _fifoLen < sizeof(_fifo); i++) _fifo[_fifoLen++] = data[i];
+    }
+    byte fifoLength() const { return _fifoLen; }
+
+    void write(byte reg, byte count, const byte *values) {
+        record(true, reg, count);
+        for (byte i = 0; i < count; i++) store(reg, values[i]);
+    }
+
+    void read(byte reg, byte count, byte *values) {
+        record(false, reg, count);
+        for (byte i = 0; i < count; i++) values[i] = load(reg);
+    }
+
+    // One transaction, like the ESP32 repeated-START frame
+    byte writeBatch(const byte *batch, byte length) {
+        if (batchFails) return 0;
+        for (byte pos = 0; pos < length; pos += 2 + batch[pos + 1]) {
+            for (byte i = 0; i < batch[pos + 1]; i++) store(batch[pos], batch[pos + 2 + i]);
+        }
+        record(true, length ? batch[0] : 0, length);
+        return 1;
+    }
+
+   private:
+    byte _fifo[64];
+    byte _fifoLen;
+    uint32_t _transactions;
+    Transaction _log[LOG_SIZE];
+    byte _logLen;
+
+    void record(bool write, byte reg, byte count) {
+        _transactions++;
+        if (_logLen < LOG_SIZE) {
+            Transaction entry = {write, reg, count};
+            _log[_logLen++] = entry;
+        }
+    }
+
+    void store(byte reg, byte value) {
+        reg &= 0x3F;
+        switch (reg) {
+            case 0x01:  // CommandReg: commands complete at once
+                registers[reg] = value & 0x20;
+                if ((value & 0x0F) != 0x00) startCommand();
+                break;
+            case 0x04:  // ComIrqReg
+            case 0x05:  // DivIrqReg: Set1 bit selects set / clear
+                if (value & 0x80) registers[reg] |= value & 0x7F;
+                else registers[reg] &= ~value;
+                break;
+            case 0x09:  // FIFODataReg
+                if (_fifoLen < sizeof(_fifo)) _fifo[_fifoLen++] = value;
+                break;
+            case 0x0A:  // FIFOLevelReg: FlushBuffer
+                if (value & 0x80) _fifoLen = 0;
+                break;
+            case 0x0D:  // BitFramingReg: StartSend
+                registers[reg] = value & 0x7F;
+                if (value & 0x80) startCommand();
+                break;
+            default:
+                registers[reg] = value;
+        }
+    }
+
+    byte load(byte reg) {
+        reg &= 0x3F;
+        if (reg == 0x09) {
+            if (_fifoLen == 0) return 0;
+            byte value = _fifo[0];
+            memmove(_fifo, _fifo + 1, --_fifoLen);
+            return value;
+        }
+        if (reg == 0x0A) return _fifoLen;
+        return registers[reg];
+    }
+
+    void startCommand() {
+        registers[0x04] |= comIrqOnCommand;
+        registers[0x05] |= divIrqOnCommand;
+    }
+};
+
+#endif
@@ -0,0 +1,76 @@
+/**
+ * MFRC522_CRC.h - Table-driven ISO/IEC 14443-3 CRC_A
+ *
+ * CRC_A is the reflected CCITT polynomial x^16 + x^12 + x^5 + 1 (0x8408)
+ * with preset 0x6363 and no final XOR, i.e. what the MFRC522 coprocessor
+ * computes with ModeReg CRCPreset = 01b. The 256-entry table is generated
+ * at compile time and lives in flash. No Arduino dependency, so the native
+ * tests can include it directly.
+ */
+#ifndef MFRC522_CRC_h
+#define MFRC522_CRC_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+class MFRC522_CRC {
+   public:
+    static const uint16_t PRESET = 0x6363;
+    static const uint16_t POLYNOMIAL = 0x8408;
+
+    static uint16_t update(uint16_t crc, const uint8_t *data, size_t length) {
+        for (size_t i = 0; i < length; i++) {
+            crc = (crc >> 8) ^ Table::values[(crc ^ data[i]) & 0xFF];
+        }
+        return crc;
+    }
+
+    static uint16_t compute(const uint8_t *data, size_t length) {
+        return update(PRESET, data, length);
+    }
+
+    // Writes the CRC the way it goes on air and in CRCResultRegL/H:
+    // low byte first.
+    static void compute(const uint8_t *data, size_t length, uint8_t *result) {
+        uint16_t crc = compute(data, length);
+        result[0] = crc & 0xFF;
+        result[1] = crc >> 8;
+    }
+
+    // Bit-serial reference (the coprocessor's shift register), for tests.
+    static uint16_t computeBitwise(const uint8_t *data, size_t length) {
+        uint16_t crc = PRESET;
+        for (size_t i = 0; i < length; i++) {
+            crc ^= data[i];
+            for (int bit = 0; bit < 8; bit++) {
+                crc = (crc & 1) ? (crc >> 1) ^ POLYNOMIAL : (crc >> 1);
+            }
+        }
+        return crc;
+    }
+
+   private:
+    // C++11 constexpr: one table entry = 8 shifts of the LFSR, unrolled
+    // recursively, expanded over the index pack 0..255.
+    static constexpr uint16_t entry(uint16_t crc, int bits) {
+        return bits == 0 ? crc
+                         : entry((crc & 1) ? (crc >> 1) ^ POLYNOMIAL : (crc >> 1), bits - 1);
+    }
+
+    template <int... I> struct Indices {};
+    template <int N, int... I> struct MakeIndices : MakeIndices<N - 1, N - 1, I...> {};
+    template <int... I> struct MakeIndices<0, I...> { typedef Indices<I...> type; };
+
+    template <class T> struct TableOf;
+    template <int... I> struct TableOf<Indices<I...> > {
+        static const uint16_t values[sizeof...(I)];
+    };
+
+    typedef TableOf<MakeIndices<256>::type> Table;
+};
+
+template <int... I>
+const uint16_t MFRC522_CRC::TableOf<MFRC522_CRC::Indices<I...> >::values[sizeof...(I)] = {
+    MFRC522_CRC::entry(I, 8)...};
+
+#endif
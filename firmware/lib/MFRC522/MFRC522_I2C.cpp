@@ -0,0 +1,19 @@
+/*
+ * MFRC522_I2C.cpp - Library for RFID MFRC522 via I2C
+ * Author: arozcan @ https://github.com/arozcan/MFRC522-I2C-Library
+ *
+ * Member definitions live in MFRC522_Impl.h; this unit instantiates the
+ * driver for the bus policies the build uses: I2C on Arduino (SPI too with
+ * -D MFRC522_WITH_SPI), the mock bus natively.
+ */
+
+#include "MFRC522_Impl.h"
+
+#if defined(ARDUINO)
+template class MFRC522Base<MFRC522_I2CBus>;
+#if defined(MFRC522_WITH_SPI)
+template class MFRC522Base<MFRC522_SPIBus>;
+#endif
+#else
+template class MFRC522Base<MFRC522_MockBus>;
+#endif
@@ -0,0 +1,1267 @@
+/**
+ * MFRC522_Impl.h - MFRC522Base<Bus> member definitions
+ *
+ * Included by MFRC522_I2C.cpp, which instantiates the driver for the bus
+ * policies of the current build. A translation unit bringing its own bus
+ * policy includes this file and adds its own explicit instantiation.
+ */
+#ifndef MFRC522_Impl_h
+#define MFRC522_Impl_h
+
+#include "MFRC522_I2C.h"
+
+#define REG_BIT(reg) (1ULL << (reg))
+
+// Registers only ever written by the host: reads are served from the shadow.
+static const uint64_t SHADOW_STATIC =
+    REG_BIT(MFRC522Defs::ComIEnReg) | REG_BIT(MFRC522Defs::DivIEnReg) |
+    REG_BIT(MFRC522Defs::WaterLevelReg) | REG_BIT(MFRC522Defs::ModeReg) |
+    REG_BIT(MFRC522Defs::TxModeReg) | REG_BIT(MFRC522Defs::RxModeReg) |
+    REG_BIT(MFRC522Defs::TxControlReg) | REG_BIT(MFRC522Defs::TxASKReg) |
+    REG_BIT(MFRC522Defs::TxSelReg) | REG_BIT(MFRC522Defs::RxSelReg) |
+    REG_BIT(MFRC522Defs::RxThresholdReg) | REG_BIT(MFRC522Defs::DemodReg) |
+    REG_BIT(MFRC522Defs::MfTxReg) | REG_BIT(MFRC522Defs::MfRxReg) |
+    REG_BIT(MFRC522Defs::ModWidthReg) | REG_BIT(MFRC522Defs::RFCfgReg) |
+    REG_BIT(MFRC522Defs::GsNReg) | REG_BIT(MFRC522Defs::CWGsPReg) |
+    REG_BIT(MFRC522Defs::ModGsPReg) | REG_BIT(MFRC522Defs::TModeReg) |
+    REG_BIT(MFRC522Defs::TPrescalerReg) | REG_BIT(MFRC522Defs::TReloadRegH) |
+    REG_BIT(MFRC522Defs::TReloadRegL);
+
+// Registers mixing host-owned and chip-owned bits: only the owned bits are
+// shadowed, for read-modify-write. The other bits are read-only (CollPos,
+// ModemState) or only cleared by the host (MFCrypto1On), so writing them
+// back as 0 is harmless.
+static byte shadowOwnedBits(byte reg) {
+    if (reg < 0x40 && (SHADOW_STATIC & REG_BIT(reg))) return 0xFF;
+    switch (reg) {
+        case MFRC522Defs::CollReg: return 0x80;     // ValuesAfterColl
+        case MFRC522Defs::Status2Reg: return 0xC0;  // TempSensClear, I2CForceHS
+        default: return 0x00;
+    }
+}
+
+// Timer reload (25 us ticks) and software deadline for each timeout profile.
+// The deadline only backs up TimerIRq, so it keeps some slack.
+static const struct {
+    uint16_t reload;
+    uint16_t waitMs;
+} TIMEOUT_PROFILES[MFRC522Defs::PCD_TIMEOUT_COUNT] = {
+    {40, 10},    // PCD_TIMEOUT_PROBE: 1 ms
+    {200, 15},   // PCD_TIMEOUT_SELECT: 5 ms
+    {1000, 40},  // PCD_TIMEOUT_MIFARE: 25 ms
+};
+
+// ModWidthReg per bit rate (NXP recommended Miller pause widths).
+static const byte MOD_WIDTH[] = {0x26, 0x15, 0x0A, 0x05};
+
+template <class Bus>
+MFRC522Base<Bus>::MFRC522Base(const Bus &bus, int8_t irqPin) : _bus(bus) {
+    _irqPin = irqPin;
+    _irqFired = false;
+    _irqTask = NULL;
+    _pollIntervalUs = 1000;
+    _shadowValid = 0;
+    _shadowVerify = false;
+    _shadowMismatches = 0;
+    _softwareCRC = true;
+    _timeoutProfile = TIMEOUT_NONE;
+    _commWaitMs = TIMEOUT_PROFILES[PCD_TIMEOUT_MIFARE].waitMs;
+    _fastReadChunk = (FIFO_SIZE - 2) / 4;
+    _bitRate = BITRATE_106;
+    _idleTimeoutMs = 0;
+    _probePeriodMs = 0;
+    _probeSettleMs = 0;
+    _lowPower = false;
+    _lastActivity = 0;
+    _lastProbe = 0;
+    memset(&_lowPowerStats, 0, sizeof(_lowPowerStats));
+    MIFARE_SetKeys(NULL, 0);
+    _batching = false;
+    _batchLen = 0;
+    _batchEntries = 0;
+    _batchLastEntry = 0;
+    PCD_ResetBusStats();
+}
+
+template <class Bus>
+void MFRC522Base<Bus>::PCD_WriteRegister(byte reg, byte value) {
+    PCD_WriteRegister(reg, 1, &value);
+}
+
+template <class Bus>
+void MFRC522Base<Bus>::PCD_WriteRegister(byte reg, byte count, byte *values) {
+    if (count == 0) return;
+    byte owned = shadowOwnedBits(reg);
+    if (owned) {
+        _shadow[reg] = values[count - 1] & owned;
+        _shadowValid |= REG_BIT(reg);
+    }
+    if (_batching) {
+        PCD_QueueWrite(reg, count, values);
+        return;
+    }
+    _bus.write(reg, count, values);
+    _busStats.transactions++;
+    _busStats.bytes += 1 + count;
+}
+
+template <class Bus>
+byte MFRC522Base<Bus>::PCD_ReadRegister(byte reg) {
+    if (shadowOwnedBits(reg) == 0xFF) return PCD_ReadShadowed(reg, 0xFF);
+    byte value = 0;
+    PCD_ReadRegister(reg, 1, &value);
+    return value;
+}
+
+// Returns the owned bits of a shadowed register, reading the chip only on a
+// miss. In verify mode every hit is checked against the chip (and corrected).
+template <class Bus>
+byte MFRC522Base<Bus>::PCD_ReadShadowed(byte reg, byte owned) {
+    bool valid = _shadowValid & REG_BIT(reg);
+    if (valid && !_shadowVerify) return _shadow[reg];
+    byte value = 0;
+    PCD_ReadRegister(reg, 1, &value);
+    value &= owned;
+    if (valid && value != _shadow[reg]) _shadowMismatches++;
+    _shadow[reg] = value;
+    _shadowValid |= REG_BIT(reg);
+    return value;
+}
+
+// Compares every valid shadow entry with the chip, resyncs it and returns
+// the number of registers that differed.
+template <class Bus>
+byte MFRC522Base<Bus>::PCD_VerifyShadow() {
+    byte mismatches = 0;
+    for (byte reg = 0; reg < 0x40; reg++) {
+        if (!(_shadowValid & REG_BIT(reg))) continue;
+        byte value = 0;
+        PCD_ReadRegister(reg, 1, &value);
+        value &= shadowOwnedBits(reg);
+        if (value != _shadow[reg]) {
+            mismatches++;
+            _shadow[reg] = value;
+        }
+    }
+    _shadowMismatches += mismatches;
+    return mismatches;
+}
+
+template <class Bus>
+void MFRC522Base<Bus>::PCD_ReadRegister(byte reg, byte count, byte *values, byte rxAlign) {
+    if (count == 0) return;
+    PCD_FlushBatch();
+    byte first = values[0];
+    _bus.read(reg, count, values);
+    _busStats.transactions++;
+    _busStats.bytes += 1 + count;
+    if (rxAlign) {
+        // Only bit positions rxAlign..7 of the first byte are received
+        byte mask = (0xFF << rxAlign) & 0xFF;
+        values[0] = (first & ~mask) | (values[0] & mask);
+    }
+}
+
+template <class Bus>
+void MFRC522Base<Bus>::PCD_BeginBatch() { _batching = true; }
+
+template <class Bus>
+void MFRC522Base<Bus>::PCD_EndBatch() {
+    PCD_FlushBatch();
+    _batching = false;
+}
+
+template <class Bus>
+void MFRC522Base<Bus>::PCD_ResetBusStats() {
+    _busStats.transactions = 0;
+    _busStats.bytes = 0;
+    _busStats.errors = 0;
+}
+
+template <class Bus>
+void MFRC522Base<Bus>::PCD_QueueWrite(byte reg, byte count, byte *values) {
+    // Consecutive writes to the same register (FIFO) are merged into one entry.
+    bool merge = _batchLen > 0 && _batch[_batchLastEntry] == reg;
+    byte needed = merge ? count : 2 + count;
+    if (_batchLen + needed > BATCH_SIZE || (!merge && _batchEntries >= BATCH_MAX_ENTRIES)) {
+        PCD_FlushBatch();
+        merge = false;
+        needed = 2 + count;
+    }
+    if (needed > BATCH_SIZE) {
+        // Larger than the queue itself: send it directly.
+        _batching = false;
+        PCD_WriteRegister(reg, count, values);
+        _batching = true;
+        return;
+    }
+    if (!merge) {
+        _batchLastEntry = _batchLen;
+        _batch[_batchLen++] = reg;
+        _batch[_batchLen++] = 0;
+        _batchEntries++;
+    }
+    memcpy(&_batch[_batchLen], values, count);
+    _batchLen += count;
+    _batch[_batchLastEntry + 1] += count;
+}
+
+template <class Bus>
+void MFRC522Base<Bus>::PCD_FlushBatch() {
+    if (_batchLen == 0) return;
+    byte transactions = _bus.writeBatch(_batch, _batchLen);
+    if (transactions == 0) {
+        _busStats.errors++;
+    } else {
+        _busStats.transactions += transactions;
+        _busStats.bytes += _batchLen - _batchEntries;
+    }
+    _batchLen = 0;
+    _batchEntries = 0;
+}
+
+template <class Bus>
+void IRAM_ATTR MFRC522Base<Bus>::PCD_IrqHandler(void *arg) {
+    MFRC522Base *self = (MFRC522Base *)arg;
+    self->_irqFired = true;
+#if defined(ESP32)
+    if (self->_irqTask) {
+        BaseType_t woken = pdFALSE;
+        vTaskNotifyGiveFromISR((TaskHandle_t)self->_irqTask, &woken);
+        if (woken) portYIELD_FROM_ISR();
+    }
+#endif
+}
+
+// Waits until one of the mask bits is set in reg (ComIrqReg / DivIrqReg) or
+// the deadline expires, and returns the last value read. With an IRQ pin the
+// register is only read once the interrupt fired; otherwise it is polled
+// every _pollIntervalUs, sleeping in between instead of hammering the bus.
+template <class Bus>
+byte MFRC522Base<Bus>::PCD_WaitForIRq(byte reg, byte mask, uint16_t timeoutMs) {
+    unsigned long start = millis();
+    for (;;) {
+        bool expired = millis() - start >= timeoutMs;
+        if (_irqPin < 0 || _irqFired || expired) {
+            _irqFired = false;
+            byte n = PCD_ReadRegister(reg);
+            if ((n & mask) || expired) return n;
+        }
+        if (_irqPin >= 0) {
+#if defined(ESP32)
+            ulTaskNotifyTake(pdTRUE, 1);
+#else
+            yield();
+#endif
+        } else if (_pollIntervalUs >= 1000) {
+            delay(_pollIntervalUs / 1000);
+        } else {
+            delayMicroseconds(_pollIntervalUs);
+        }
+    }
+}
+
+template <class Bus>
+void MFRC522Base<Bus>::PCD_SetRegisterBitMask(byte reg, byte mask) {
+    byte owned = shadowOwnedBits(reg);
+    byte value = owned ? PCD_ReadShadowed(reg, owned) : PCD_ReadRegister(reg);
+    PCD_WriteRegister(reg, value | mask);
+}
+
+template <class Bus>
+void MFRC522Base<Bus>::PCD_ClearRegisterBitMask(byte reg, byte mask) {
+    byte owned = shadowOwnedBits(reg);
+    byte value = owned ? PCD_ReadShadowed(reg, owned) : PCD_ReadRegister(reg);
+    PCD_WriteRegister(reg, value & (~mask));
+}
+
+template <class Bus>
+byte MFRC522Base<Bus>::PCD_CalculateCRC(byte *data, byte length, byte *result) {
+    if (_softwareCRC) {
+        MFRC522_CRC::compute(data, length, result);
+        return STATUS_OK;
+    }
+    PCD_BeginBatch();
+    PCD_WriteRegister(CommandReg, PCD_Idle);
+    PCD_WriteRegister(DivIrqReg, 0x04);
+    // Stale ComIrqReg bits would hold the IRQ line low and hide the CRC edge
+    if (_irqPin >= 0) PCD_WriteRegister(ComIrqReg, 0x7F);
+    PCD_WriteRegister(FIFOLevelReg, 0x80);
+    PCD_WriteRegister(FIFODataReg, length, data);
+    _irqFired = false;
+    PCD_WriteRegister(CommandReg, PCD_CalcCRC);
+    PCD_EndBatch();
+    byte n = PCD_WaitForIRq(DivIrqReg, 0x04, CRC_WAIT_MS);
+    if (!(n & 0x04)) return STATUS_TIMEOUT;
+    PCD_WriteRegister(CommandReg, PCD_Idle);
+    result[0] = PCD_ReadRegister(CRCResultRegL);
+    result[1] = PCD_ReadRegister(CRCResultRegH);
+    return STATUS_OK;
+}
+
+template <class Bus>
+void MFRC522Base<Bus>::PCD_Init() {
+    PCD_Reset();
+    if (_irqPin >= 0) {
+#if defined(ESP32)
+        _irqTask = xTaskGetCurrentTaskHandle();
+        ulTaskNotifyTake(pdTRUE, 0);
+        pinMode(_irqPin, INPUT_PULLUP);
+        attachInterruptArg(digitalPinToInterrupt(_irqPin), PCD_IrqHandler, this, FALLING);
+#endif
+        // IRQ active low on RxIRq | IdleIRq | TimerIRq, push-pull, plus CRCIRq
+        PCD_WriteRegister(ComIEnReg, 0x80 | 0x20 | 0x10 | 0x01);
+        PCD_WriteRegister(DivIEnReg, 0x80 | 0x04);
+    }
+    PCD_WriteRegister(TModeReg, 0x80);
+    PCD_WriteRegister(TPrescalerReg, 0xA9);
+    PCD_SetTimeoutProfile(PCD_TIMEOUT_MIFARE);
+    PCD_WriteRegister(TxASKReg, 0x40);
+    PCD_WriteRegister(ModeReg, 0x3D);
+    PCD_AntennaOn();
+}
+
+template <class Bus>
+void MFRC522Base<Bus>::PCD_Reset() {
+    PCD_WriteRegister(CommandReg, PCD_SoftReset);
+    _shadowValid = 0;
+    _timeoutProfile = TIMEOUT_NONE;
+    _bitRate = BITRATE_106;
+    delay(50);
+    while (PCD_ReadRegister(CommandReg) & (1 << 4));
+}
+
+// Reprograms TReloadReg only when the profile actually changes, so the
+// idle REQA loop does not pay for it.
+template <class Bus>
+void MFRC522Base<Bus>::PCD_SetTimeoutProfile(byte profile) {
+    if (profile >= PCD_TIMEOUT_COUNT || profile == _timeoutProfile) return;
+    uint16_t reload = TIMEOUT_PROFILES[profile].reload;
+    PCD_BeginBatch();
+    PCD_WriteRegister(TReloadRegH, reload >> 8);
+    PCD_WriteRegister(TReloadRegL, reload & 0xFF);
+    PCD_EndBatch();
+    _timeoutProfile = profile;
+    _commWaitMs = TIMEOUT_PROFILES[profile].waitMs;
+}
+
+// Programs the same rate in both directions, with the matching modulation
+// width. CRC stays off in hardware: the driver appends and checks it.
+template <class Bus>
+void MFRC522Base<Bus>::PCD_SetBitRate(byte rate) {
+    if (rate > BITRATE_848 || rate == _bitRate) return;
+    PCD_BeginBatch();
+    PCD_WriteRegister(TxModeReg, rate << 4);
+    PCD_WriteRegister(RxModeReg, rate << 4);
+    PCD_WriteRegister(ModWidthReg, MOD_WIDTH[rate]);
+    PCD_EndBatch();
+    _bitRate = rate;
+}
+
+template <class Bus>
+void MFRC522Base<Bus>::PCD_AntennaOn() {
+    byte value = PCD_ReadRegister(TxControlReg);
+    if ((value & 0x03) != 0x03) PCD_WriteRegister(TxControlReg, value | 0x03);
+}
+
+template <class Bus>
+void MFRC522Base<Bus>::PCD_AntennaOff() { PCD_ClearRegisterBitMask(TxControlReg, 0x03); }
+
+template <class Bus>
+byte MFRC522Base<Bus>::PCD_GetAntennaGain() { return PCD_ReadRegister(RFCfgReg) & (0x07 << 4); }
+
+template <class Bus>
+MFRC522Defs::RxConfig MFRC522Base<Bus>::PCD_GetRxConfig() {
+    RxConfig config;
+    config.gain = PCD_GetAntennaGain();
+    config.rxThreshold = PCD_ReadRegister(RxThresholdReg);
+    config.demod = PCD_ReadRegister(DemodReg);
+    return config;
+}
+
+template <class Bus>
+void MFRC522Base<Bus>::PCD_SetRxConfig(const RxConfig &config) {
+    PCD_SetAntennaGain(config.gain);
+    PCD_WriteRegister(RxThresholdReg, config.rxThreshold);
+    PCD_WriteRegister(DemodReg, config.demod);
+}
+
+// Calibration grid: receiver gain x RxThresholdReg MinLevel (CollLevel kept
+// at 4) x DemodReg AddIQ (strongest channel frozen / I+Q combined).
+static const byte CAL_GAINS[] = {MFRC522Defs::RxGain_33dB, MFRC522Defs::RxGain_38dB,
+                                 MFRC522Defs::RxGain_43dB, MFRC522Defs::RxGain_48dB};
+static const byte CAL_THRESHOLDS[] = {0x54, 0x84, 0xB4};
+static const byte CAL_DEMODS[] = {0x4D, 0x8D};
+
+// Sweeps the grid against a tag held in the field: each candidate gets
+// `attempts` WUPA + select cycles (no retry, HLTA in between) and is scored
+// by successes, then mean select time. The best setting is left applied.
+// Returns STATUS_TIMEOUT if no candidate ever reached the tag.
+template <class Bus>
+byte MFRC522Base<Bus>::PCD_CalibrateRx(byte attempts, RxScore *best) {
+    RxConfig original = PCD_GetRxConfig();
+    memset(best, 0, sizeof(RxScore));
+    best->config = original;
+
+    for (byte g = 0; g < sizeof(CAL_GAINS); g++) {
+        for (byte t = 0; t < sizeof(CAL_THRESHOLDS); t++) {
+            for (byte d = 0; d < sizeof(CAL_DEMODS); d++) {
+                RxScore score;
+                score.config.gain = CAL_GAINS[g];
+                score.config.rxThreshold = CAL_THRESHOLDS[t];
+                score.config.demod = CAL_DEMODS[d];
+                score.successes = 0;
+                score.attempts = attempts;
+                PCD_SetRxConfig(score.config);
+
+                uint32_t totalUs = 0;
+                for (byte i = 0; i < attempts; i++) {
+                    unsigned long start = micros();
+                    byte result = PICC_DetectAndSelect(&uid, true, 0, 0);
+                    unsigned long elapsed = micros() - start;
+                    if (result == STATUS_OK) {
+                        score.successes++;
+                        totalUs += elapsed;
+                        PICC_HaltA();
+                    }
+                }
+                score.avgSelectUs = score.successes ? totalUs / score.successes : 0;
+
+                if (score.successes > best->successes ||
+                    (score.successes == best->successes && score.successes > 0 &&
+                     score.avgSelectUs < best->avgSelectUs)) {
+                    *best = score;
+                }
+            }
+        }
+    }
+
+    PCD_SetRxConfig(best->config);
+    return best->successes ? STATUS_OK : STATUS_TIMEOUT;
+}
+
+template <class Bus>
+void MFRC522Base<Bus>::PCD_SetAntennaGain(byte mask) {
+    if (PCD_GetAntennaGain() != mask) {
+        byte value = PCD_ReadRegister(RFCfgReg) & ~(0x07 << 4);
+        PCD_WriteRegister(RFCfgReg, value | (mask & (0x07 << 4)));
+    }
+}
+
+template <class Bus>
+bool MFRC522Base<Bus>::PCD_PerformSelfTest() {
+    PCD_Reset();
+    byte ZEROES[25] = {0x00};
+    PCD_WriteRegister(FIFOLevelReg, 0x80);
+    PCD_WriteRegister(FIFODataReg, 25, ZEROES);
+    PCD_WriteRegister(CommandReg, PCD_Mem);
+    PCD_WriteRegister(AutoTestReg, 0x09);
+    PCD_WriteRegister(FIFODataReg, 0x00);
+    PCD_WriteRegister(CommandReg, PCD_CalcCRC);
+    for (word i = 0; i < 0xFF; i++) {
+        if (PCD_ReadRegister(DivIrqReg) & 0x04) break;
+    }
+    PCD_WriteRegister(CommandReg, PCD_Idle);
+    byte result[64];
+    PCD_ReadRegister(FIFODataReg, 64, result, 0);
+    PCD_WriteRegister(AutoTestReg, 0x00);
+    byte version = PCD_ReadRegister(VersionReg);
+    const byte *reference;
+    switch (version) {
+        case 0x88: reference = FM17522_firmware_reference; break;
+        case 0x90: reference = MFRC522_firmware_referenceV0_0; break;
+        case 0x91: reference = MFRC522_firmware_referenceV1_0; break;
+        case 0x92: reference = MFRC522_firmware_referenceV2_0; break;
+        default: return false;
+    }
+    for (word i = 0; i < 64; i++) {
+        if (result[i] != pgm_read_byte(&(reference[i]))) return false;
+    }
+    return true;
+}
+
+template <class Bus>
+byte MFRC522Base<Bus>::PCD_TransceiveData(byte *sendData, byte sendLen, byte *backData,
+                                 byte *backLen, byte *validBits, byte rxAlign, bool checkCRC) {
+    return PCD_CommunicateWithPICC(PCD_Transceive, 0x30, sendData, sendLen,
+                                   backData, backLen, validBits, rxAlign, checkCRC);
+}
+
+template <class Bus>
+byte MFRC522Base<Bus>::PCD_CommunicateWithPICC(byte command, byte waitIRq, byte *sendData,
+                                      byte sendLen, byte *backData, byte *backLen,
+                                      byte *validBits, byte rxAlign, bool checkCRC) {
+    byte txLastBits = validBits ? *validBits : 0;
+    byte bitFraming = (rxAlign << 4) + txLastBits;
+    // FlushBuffer and StartSend are plain writes: FIFOLevelReg bits 6..0 are
+    // read-only and BitFramingReg is fully known, so no read-modify-write.
+    PCD_BeginBatch();
+    PCD_WriteRegister(CommandReg, PCD_Idle);
+    PCD_WriteRegister(ComIrqReg, 0x7F);
+    if (_irqPin >= 0) PCD_WriteRegister(DivIrqReg, 0x04);
+    PCD_WriteRegister(FIFOLevelReg, 0x80);
+    PCD_WriteRegister(FIFODataReg, sendLen, sendData);
+    _irqFired = false;
+    if (command == PCD_Transceive) {
+        PCD_WriteRegister(CommandReg, command);
+        PCD_WriteRegister(BitFramingReg, bitFraming | 0x80);
+    } else {
+        PCD_WriteRegister(BitFramingReg, bitFraming);
+        PCD_WriteRegister(CommandReg, command);
+    }
+    PCD_EndBatch();
+
+    byte irq = PCD_WaitForIRq(ComIrqReg, waitIRq | 0x01, _commWaitMs);
+    if (!(irq & waitIRq)) return STATUS_TIMEOUT;
+
+    byte errorReg = PCD_ReadRegister(ErrorReg);
+    if (errorReg & 0x13) return STATUS_ERROR;
+
+    byte _validBits = 0;
+    if (backData && backLen) {
+        byte n = PCD_ReadRegister(FIFOLevelReg);
+        if (n > *backLen) return STATUS_NO_ROOM;
+        *backLen = n;
+        PCD_ReadRegister(FIFODataReg, n, backData, rxAlign);
+        _validBits = PCD_ReadRegister(ControlReg) & 0x07;
+        if (validBits) *validBits = _validBits;
+    }
+
+    if (errorReg & 0x08) return STATUS_COLLISION;
+
+    if (backData && backLen && checkCRC) {
+        if (*backLen == 1 && _validBits == 4) return STATUS_MIFARE_NACK;
+        if (*backLen < 2 || _validBits != 0) return STATUS_CRC_WRONG;
+        byte controlBuffer[2];
+        byte n = PCD_CalculateCRC(&backData[0], *backLen - 2, &controlBuffer[0]);
+        if (n != STATUS_OK) return n;
+        if ((backData[*backLen - 2] != controlBuffer[0]) ||
+            (backData[*backLen - 1] != controlBuffer[1])) return STATUS_CRC_WRONG;
+    }
+    return STATUS_OK;
+}
+
+// Transceive for frames larger than the 64-byte FIFO, in either direction.
+// While transmitting, the FIFO is refilled from sendData each time it drops
+// to the LoAlert watermark; while receiving, it is drained into backData each
+// time it reaches HiAlert, so the PICC never waits for the host.
+// *backLen is the capacity in, the received length out. With checkCRC the
+// trailing CRC_A is verified in software (and left in the buffer).
+template <class Bus>
+byte MFRC522Base<Bus>::PCD_TransceiveStream(byte *sendData, uint16_t sendLen, byte *backData,
+                                   uint16_t *backLen, byte *validBits, bool checkCRC) {
+    if (backData == NULL || backLen == NULL) return STATUS_INVALID;
+    uint16_t capacity = *backLen;
+    uint16_t received = 0;
+    uint16_t sent = sendLen > FIFO_SIZE ? FIFO_SIZE : sendLen;
+    byte status = STATUS_OK;
+
+    // LoAlertIEn only while transmitting: LoAlert holds during reception
+    if (_irqPin >= 0) PCD_SetRegisterBitMask(ComIEnReg, sent < sendLen ? 0x0C : 0x08);
+    PCD_BeginBatch();
+    PCD_WriteRegister(CommandReg, PCD_Idle);
+    PCD_WriteRegister(ComIrqReg, 0x7F);
+    if (_irqPin >= 0) PCD_WriteRegister(DivIrqReg, 0x04);
+    PCD_WriteRegister(FIFOLevelReg, 0x80);
+    PCD_WriteRegister(WaterLevelReg, STREAM_WATER_LEVEL);
+    PCD_WriteRegister(FIFODataReg, sent, sendData);
+    _irqFired = false;
+    PCD_WriteRegister(CommandReg, PCD_Transceive);
+    PCD_WriteRegister(BitFramingReg, 0x80);
+    PCD_EndBatch();
+
+    // The FIFO drains or fills in ~2.7 ms at 106 kbps: poll without sleeping
+    uint16_t pollIntervalUs = _pollIntervalUs;
+    _pollIntervalUs = 0;
+
+    while (sent < sendLen) {
+        byte irq = PCD_WaitForIRq(ComIrqReg, 0x04, _commWaitMs);  // LoAlertIRq
+        if (!(irq & 0x04)) {
+            status = STATUS_TIMEOUT;
+            break;
+        }
+        byte room = FIFO_SIZE - (PCD_ReadRegister(FIFOLevelReg) & 0x7F);
+        uint16_t chunk = sendLen - sent < room ? sendLen - sent : room;
+        PCD_BeginBatch();
+        PCD_WriteRegister(FIFODataReg, chunk, &sendData[sent]);
+        PCD_WriteRegister(ComIrqReg, 0x04);
+        PCD_EndBatch();
+        sent += chunk;
+    }
+    if (_irqPin >= 0 && sendLen > FIFO_SIZE) PCD_ClearRegisterBitMask(ComIEnReg, 0x04);
+
+    while (status == STATUS_OK) {
+        byte irq = PCD_WaitForIRq(ComIrqReg, 0x20 | 0x08 | 0x01, _commWaitMs);
+        byte level = PCD_ReadRegister(FIFOLevelReg) & 0x7F;
+        if (received + level > capacity) {
+            status = STATUS_NO_ROOM;
+            break;
+        }
+        if (level) {
+            PCD_ReadRegister(FIFODataReg, level, &backData[received]);
+            received += level;
+        }
+        if (irq & 0x20) break;  // RxIRq: everything was in the FIFO
+        if (!(irq & 0x08)) {
+            status = STATUS_TIMEOUT;
+            break;
+        }
+        PCD_WriteRegister(ComIrqReg, 0x08);  // HiAlertIRq, re-armed by the next fill
+    }
+    _pollIntervalUs = pollIntervalUs;
+    if (_irqPin >= 0) PCD_ClearRegisterBitMask(ComIEnReg, 0x08);
+    if (status != STATUS_OK) return status;
+
+    byte errorReg = PCD_ReadRegister(ErrorReg);
+    if (errorReg & 0x13) return STATUS_ERROR;
+    *backLen = received;
+    byte _validBits = PCD_ReadRegister(ControlReg) & 0x07;
+    if (validBits) *validBits = _validBits;
+    if (errorReg & 0x08) return STATUS_COLLISION;
+
+    if (checkCRC) {
+        if (received == 1 && _validBits == 4) return STATUS_MIFARE_NACK;
+        if (received < 2 || _validBits != 0) return STATUS_CRC_WRONG;
+        // Data followed by its CRC_A leaves a zero residue
+        if (MFRC522_CRC::compute(backData, received) != 0) return STATUS_CRC_WRONG;
+    }
+    return STATUS_OK;
+}
+
+template <class Bus>
+byte MFRC522Base<Bus>::PICC_RequestA(byte *bufferATQA, byte *bufferSize) {
+    return PICC_REQA_or_WUPA(PICC_CMD_REQA, bufferATQA, bufferSize);
+}
+
+template <class Bus>
+byte MFRC522Base<Bus>::PICC_WakeupA(byte *bufferATQA, byte *bufferSize) {
+    return PICC_REQA_or_WUPA(PICC_CMD_WUPA, bufferATQA, bufferSize);
+}
+
+template <class Bus>
+byte MFRC522Base<Bus>::PICC_REQA_or_WUPA(byte command, byte *bufferATQA, byte *bufferSize) {
+    if (bufferATQA == NULL || *bufferSize < 2) return STATUS_NO_ROOM;
+    // Idle tags only listen at 106 kbps: drop a rate left by the last parcel
+    PCD_SetBitRate(BITRATE_106);
+    PCD_SetTimeoutProfile(PCD_TIMEOUT_PROBE);
+    PCD_ClearRegisterBitMask(CollReg, 0x80);
+    byte validBits = 7;
+    byte status = PCD_TransceiveData(&command, 1, bufferATQA, bufferSize, &validBits);
+    if (status != STATUS_OK) return status;
+    if (*bufferSize != 2 || validBits != 0) return STATUS_ERROR;
+    return STATUS_OK;
+}
+
+template <class Bus>
+byte MFRC522Base<Bus>::PICC_Select(Uid *uid, byte validBits) {
+    bool uidComplete = false;
+    byte cascadeLevel = 1;
+
+    if (validBits > 80) return STATUS_INVALID;
+    PCD_SetTimeoutProfile(PCD_TIMEOUT_SELECT);
+    PCD_ClearRegisterBitMask(CollReg, 0x80);
+
+    while (!uidComplete) {
+        byte buffer[9];
+        byte uidIndex;
+        bool useCascadeTag;
+
+        switch (cascadeLevel) {
+            case 1: buffer[0] = PICC_CMD_SEL_CL1; uidIndex = 0; useCascadeTag = validBits && uid->size > 4; break;
+            case 2: buffer[0] = PICC_CMD_SEL_CL2; uidIndex = 3; useCascadeTag = validBits && uid->size > 7; break;
+            case 3: buffer[0] = PICC_CMD_SEL_CL3; uidIndex = 6; useCascadeTag = false; break;
+            default: return STATUS_INTERNAL_ERROR;
+        }
+
+        int8_t currentLevelKnownBits = validBits - (8 * uidIndex);
+        if (currentLevelKnownBits < 0) currentLevelKnownBits = 0;
+
+        byte index = 2;
+        if (useCascadeTag) buffer[index++] = PICC_CMD_CT;
+
+        byte bytesToCopy = currentLevelKnownBits / 8 + (currentLevelKnownBits % 8 ? 1 : 0);
+        if (bytesToCopy) {
+            byte maxBytes = useCascadeTag ? 3 : 4;
+            if (bytesToCopy > maxBytes) bytesToCopy = maxBytes;
+            for (byte count = 0; count < bytesToCopy; count++) {
+                buffer[index++] = uid->uidByte[uidIndex + count];
+            }
+        }
+        if (useCascadeTag) currentLevelKnownBits += 8;
+
+        bool selectDone = false;
+        while (!selectDone) {
+            byte txLastBits, bufferUsed, responseLength;
+            byte *responseBuffer;
+            byte result;
+
+            if (currentLevelKnownBits >= 32) {
+                buffer[1] = 0x70;
+                buffer[6] = buffer[2] ^ buffer[3] ^ buffer[4] ^ buffer[5];
+                result = PCD_CalculateCRC(buffer, 7, &buffer[7]);
+                if (result != STATUS_OK) return result;
+                txLastBits = 0;
+                bufferUsed = 9;
+                responseBuffer = &buffer[6];
+                responseLength = 3;
+            } else {
+                txLastBits = currentLevelKnownBits % 8;
+                byte count = currentLevelKnownBits / 8;
+                index = 2 + count;
+                buffer[1] = (index << 4) + txLastBits;
+                bufferUsed = index + (txLastBits ? 1 : 0);
+                responseBuffer = &buffer[index];
+                responseLength = sizeof(buffer) - index;
+            }
+
+            byte rxAlign = txLastBits;
+            result = PCD_TransceiveData(buffer, bufferUsed, responseBuffer, &responseLength, &txLastBits, rxAlign);
+
+            if (result == STATUS_COLLISION) {
+                result = PCD_ReadRegister(CollReg);
+                if (result & 0x20) return STATUS_COLLISION;
+                byte collisionPos = result & 0x1F;
+                if (collisionPos == 0) collisionPos = 32;
+                if (collisionPos <= currentLevelKnownBits) return STATUS_INTERNAL_ERROR;
+                // Take the colliding bit (0-based collisionPos - 1) as 1
+                currentLevelKnownBits = collisionPos;
+                buffer[2 + (collisionPos - 1) / 8] |= 1 << ((collisionPos - 1) % 8);
+            } else if (result != STATUS_OK) {
+                return result;
+            } else {
+                selectDone = (currentLevelKnownBits >= 32);
+                if (!selectDone) currentLevelKnownBits = 32;
+            }
+        }
+
+        index = (buffer[2] == PICC_CMD_CT) ? 3 : 2;
+        bytesToCopy = (buffer[2] == PICC_CMD_CT) ? 3 : 4;
+        for (byte count = 0; count < bytesToCopy; count++) {
+            uid->uidByte[uidIndex + count] = buffer[index++];
+        }
+
+        byte *responseBuffer = &buffer[6];
+        if (responseBuffer[0] & 0x04) {
+            cascadeLevel++;
+        } else {
+            uidComplete = true;
+            uid->sak = responseBuffer[0];
+        }
+    }
+    uid->size = 3 * cascadeLevel + 1;
+    return STATUS_OK;
+}
+
+template <class Bus>
+byte MFRC522Base<Bus>::PICC_HaltA() {
+    byte buffer[4];
+    buffer[0] = PICC_CMD_HLTA;
+    buffer[1] = 0;
+    byte result = PCD_CalculateCRC(buffer, 2, &buffer[2]);
+    if (result != STATUS_OK) return result;
+    // Success is the absence of an answer: keep the wait short
+    PCD_SetTimeoutProfile(PCD_TIMEOUT_PROBE);
+    result = PCD_TransceiveData(buffer, sizeof(buffer), NULL, 0);
+    if (result == STATUS_TIMEOUT) return STATUS_OK;
+    if (result == STATUS_OK) return STATUS_ERROR;
+    return result;
+}
+
+// Reads every tag in the field in one pass: select one tag (anticollision
+// resolves collisions towards bit 1), halt it so it stops answering REQA, and
+// repeat until REQA gets no answer. Returns the number of UIDs in out[].
+template <class Bus>
+byte MFRC522Base<Bus>::PICC_Inventory(Uid *out, byte max) {
+    byte found = 0;
+    byte failures = 0;
+    while (found < max && failures < 3) {
+        byte bufferATQA[2];
+        byte bufferSize = sizeof(bufferATQA);
+        byte result = PICC_RequestA(bufferATQA, &bufferSize);
+        if (result == STATUS_TIMEOUT) break;  // nobody left in the field
+        if (result != STATUS_OK && result != STATUS_COLLISION) {
+            failures++;
+            continue;
+        }
+
+        Uid *tag = &out[found];
+        memset(tag, 0, sizeof(Uid));
+        if (PICC_Select(tag) != STATUS_OK) {
+            failures++;
+            continue;
+        }
+        PICC_HaltA();
+
+        // A tag that missed its HLTA answers again: do not count it twice
+        bool duplicate = false;
+        for (byte i = 0; i < found && !duplicate; i++) {
+            duplicate = out[i].size == tag->size &&
+                        memcmp(out[i].uidByte, tag->uidByte, tag->size) == 0;
+        }
+        if (duplicate) {
+            failures++;
+        } else {
+            found++;
+        }
+    }
+    return found;
+}
+
+// Opt-in step after PICC_Select for ISO 14443-4 tags: RATS, then PPS to the
+// highest rate both the tag (ATS TA1) and maxRate allow, then reprograms the
+// PCD. Other tags stay at 106 kbps. *rate receives the rate in use. The next
+// REQA/WUPA falls back to 106 kbps on its own.
+template <class Bus>
+byte MFRC522Base<Bus>::PICC_NegotiateBitRate(byte maxRate, byte *rate) {
+    *rate = BITRATE_106;
+    if (!(uid.sak & 0x20)) return STATUS_OK;  // no ISO 14443-4 support
+
+    // RATS: FSDI = 5 (64-byte frames, our FIFO), CID 0
+    byte buffer[FIFO_SIZE];
+    buffer[0] = PICC_CMD_RATS;
+    buffer[1] = 0x50;
+    byte result = PCD_CalculateCRC(buffer, 2, &buffer[2]);
+    if (result != STATUS_OK) return result;
+    byte backLen = sizeof(buffer);
+    PCD_SetTimeoutProfile(PCD_TIMEOUT_MIFARE);
+    result = PCD_TransceiveData(buffer, 4, buffer, &backLen, NULL, 0, true);
+    if (result != STATUS_OK) return result;
+
+    // ATS: TL T0 [TA1] ... TA1 present when T0 bit 5 is set
+    if (backLen < 5 || !(buffer[1] & 0x10)) return STATUS_OK;
+    byte ta1 = buffer[2];
+    byte supported = (ta1 >> 4) & ta1 & 0x07;  // DS and DR both allowed
+    byte target = BITRATE_106;
+    for (byte r = BITRATE_212; r <= maxRate && r <= BITRATE_848; r++) {
+        if (supported & (1 << (r - 1))) target = r;
+    }
+    if (target == BITRATE_106) return STATUS_OK;
+
+    // PPS: PPS0 announces PPS1 = DSI << 2 | DRI
+    buffer[0] = PICC_CMD_PPS;
+    buffer[1] = 0x11;
+    buffer[2] = (target << 2) | target;
+    result = PCD_CalculateCRC(buffer, 3, &buffer[3]);
+    if (result != STATUS_OK) return result;
+    backLen = sizeof(buffer);
+    result = PCD_TransceiveData(buffer, 5, buffer, &backLen, NULL, 0, true);
+    if (result != STATUS_OK) return result;
+    if (backLen != 3 || buffer[0] != PICC_CMD_PPS) return STATUS_ERROR;
+
+    PCD_SetBitRate(target);
+    *rate = target;
+    return STATUS_OK;
+}
+
+template <class Bus>
+byte MFRC522Base<Bus>::PCD_Authenticate(byte command, byte blockAddr, MIFARE_Key *key, Uid *uid) {
+    byte sendData[12];
+    sendData[0] = command;
+    sendData[1] = blockAddr;
+    for (byte i = 0; i < MF_KEY_SIZE; i++) sendData[2 + i] = key->keyByte[i];
+    for (byte i = 0; i < 4; i++) sendData[8 + i] = uid->uidByte[i];
+    PCD_SetTimeoutProfile(PCD_TIMEOUT_MIFARE);
+    return PCD_CommunicateWithPICC(PCD_MFAuthent, 0x10, &sendData[0], sizeof(sendData));
+}
+
+template <class Bus>
+void MFRC522Base<Bus>::PCD_StopCrypto1() { PCD_ClearRegisterBitMask(Status2Reg, 0x08); }
+
+template <class Bus>
+byte MFRC522Base<Bus>::MIFARE_Read(byte blockAddr, byte *buffer, byte *bufferSize) {
+    if (buffer == NULL || *bufferSize < 18) return STATUS_NO_ROOM;
+    buffer[0] = PICC_CMD_MF_READ;
+    buffer[1] = blockAddr;
+    byte result = PCD_CalculateCRC(buffer, 2, &buffer[2]);
+    if (result != STATUS_OK) return result;
+    PCD_SetTimeoutProfile(PCD_TIMEOUT_MIFARE);
+    return PCD_TransceiveData(buffer, 4, buffer, bufferSize, NULL, 0, true);
+}
+
+template <class Bus>
+byte MFRC522Base<Bus>::MIFARE_Write(byte blockAddr, byte *buffer, byte bufferSize) {
+    if (buffer == NULL || bufferSize < 16) return STATUS_INVALID;
+    byte cmdBuffer[2] = {PICC_CMD_MF_WRITE, blockAddr};
+    byte result = PCD_MIFARE_Transceive(cmdBuffer, 2);
+    if (result != STATUS_OK) return result;
+    return PCD_MIFARE_Transceive(buffer, bufferSize);
+}
+
+// Ultralight WRITE: one 4-byte page per frame.
+template <class Bus>
+byte MFRC522Base<Bus>::MIFARE_Ultralight_Write(byte page, byte *buffer, byte bufferSize) {
+    if (buffer == NULL || bufferSize < 4) return STATUS_INVALID;
+    byte cmdBuffer[6] = {PICC_CMD_UL_WRITE, page};
+    memcpy(&cmdBuffer[2], buffer, 4);
+    return PCD_MIFARE_Transceive(cmdBuffer, 6);
+}
+
+// NTAG / Ultralight EV1 FAST_READ of pages startPage..endPage, in frames of
+// _fastReadChunk pages. Like MIFARE_Read, the buffer needs 2 spare bytes for
+// the CRC_A; *bufferSize returns the number of data bytes.
+template <class Bus>
+byte MFRC522Base<Bus>::MIFARE_FastRead(byte startPage, byte endPage, byte *buffer, uint16_t *bufferSize) {
+    if (buffer == NULL || endPage < startPage) return STATUS_INVALID;
+    uint16_t length = (endPage - startPage + 1) * 4;
+    if (*bufferSize < length + 2) return STATUS_NO_ROOM;
+
+    uint16_t offset = 0;
+    byte page = startPage;
+    for (;;) {
+        byte last = (endPage - page >= _fastReadChunk) ? page + _fastReadChunk - 1 : endPage;
+        byte cmdBuffer[5] = {PICC_CMD_UL_FAST_READ, page, last};
+        byte result = PCD_CalculateCRC(cmdBuffer, 3, &cmdBuffer[3]);
+        if (result != STATUS_OK) return result;
+
+        uint16_t expected = (last - page + 1) * 4 + 2;
+        uint16_t received = expected;
+        byte validBits = 0;
+        PCD_SetTimeoutProfile(PCD_TIMEOUT_MIFARE);
+        result = PCD_TransceiveStream(cmdBuffer, sizeof(cmdBuffer), &buffer[offset],
+                                      &received, &validBits, true);
+        if (result != STATUS_OK) return result;
+        if (received != expected) return STATUS_ERROR;
+
+        offset += received - 2;
+        if (last == endPage) break;
+        page = last + 1;
+    }
+    *bufferSize = offset;
+    return STATUS_OK;
+}
+
+// Reads pages startPage..endPage of the selected Ultralight-family tag with
+// FAST_READ, falling back to 4-page READ commands for tags without it
+// (original Ultralight / Ultralight C, or a SAK that is not Ultralight).
+template <class Bus>
+byte MFRC522Base<Bus>::MIFARE_ReadPages(byte startPage, byte endPage, byte *buffer, uint16_t *bufferSize) {
+    if (buffer == NULL || endPage < startPage) return STATUS_INVALID;
+    uint16_t length = (endPage - startPage + 1) * 4;
+    if (*bufferSize < length + 2) return STATUS_NO_ROOM;
+
+    if (PICC_GetType(uid.sak) == PICC_TYPE_MIFARE_UL) {
+        byte result = MIFARE_FastRead(startPage, endPage, buffer, bufferSize);
+        if (result != STATUS_MIFARE_NACK && result != STATUS_TIMEOUT) return result;
+        // FAST_READ unsupported: the NAK sent the tag back to IDLE, select it again
+        byte bufferATQA[2];
+        byte atqaSize = sizeof(bufferATQA);
+        Uid again = uid;
+        if (PICC_WakeupA(bufferATQA, &atqaSize) != STATUS_OK) return STATUS_ERROR;
+        result = PICC_Select(&again, again.size * 8);
+        if (result != STATUS_OK) return result;
+    }
+
+    uint16_t offset = 0;
+    for (uint16_t page = startPage; page <= endPage; page += 4) {
+        byte block[18];
+        byte blockSize = sizeof(block);
+        byte result = MIFARE_Read(page, block, &blockSize);
+        if (result != STATUS_OK) return result;
+        byte count = (length - offset < 16) ? length - offset : 16;
+        memcpy(&buffer[offset], block, count);
+        offset += count;
+    }
+    *bufferSize = offset;
+    return STATUS_OK;
+}
+
+template <class Bus>
+void MFRC522Base<Bus>::MIFARE_SetKeys(const MIFARE_Key *keys, byte count, byte keyType) {
+    _keys = count ? keys : NULL;
+    _keyCount = count;
+    _keyType = keyType;
+    memset(_sectorKey, MF_NO_KEY, sizeof(_sectorKey));
+}
+
+// Authenticates one sector of the tag selected in `uid`, starting with the
+// key that opened it last time. A rejected key drops the tag to IDLE, so it
+// is woken and selected again before the next key is tried.
+template <class Bus>
+byte MFRC522Base<Bus>::MIFARE_AuthenticateSector(byte sector) {
+    if (sector >= MF_MAX_SECTORS) return STATUS_INVALID;
+    byte trailer = MIFARE_SectorFirstBlock(sector) + MIFARE_SectorBlocks(sector) - 1;
+    byte count = _keys ? _keyCount : 1;
+    byte first = _sectorKey[sector] < count ? _sectorKey[sector] : 0;
+    byte result = STATUS_TIMEOUT;
+
+    for (byte attempt = 0; attempt < count; attempt++) {
+        byte index = (first + attempt) % count;
+        MIFARE_Key key;
+        if (_keys) key = _keys[index];
+        else memset(key.keyByte, 0xFF, MF_KEY_SIZE);
+
+        if (attempt > 0) {
+            PCD_StopCrypto1();
+            byte bufferATQA[2];
+            byte bufferSize = sizeof(bufferATQA);
+            Uid again = uid;
+            result = PICC_WakeupA(bufferATQA, &bufferSize);
+            if (result != STATUS_OK) return result;
+            result = PICC_Select(&again, again.size * 8);
+            if (result != STATUS_OK) return result;
+        }
+        result = PCD_Authenticate(_keyType, trailer, &key, &uid);
+        if (result == STATUS_OK) {
+            _sectorKey[sector] = index;
+            return result;
+        }
+        if (result != STATUS_TIMEOUT) return result;
+    }
+    _sectorKey[sector] = MF_NO_KEY;
+    return result;
+}
+
+// One authentication, then the data blocks of the sector back to back (the
+// trailer is not read). *bufferSize: capacity in, bytes read out.
+template <class Bus>
+byte MFRC522Base<Bus>::MIFARE_ReadSector(byte sector, byte *buffer, byte *bufferSize,
+                                         SectorTiming *timing) {
+    if (buffer == NULL || sector >= MF_MAX_SECTORS) return STATUS_INVALID;
+    byte dataBlocks = MIFARE_SectorBlocks(sector) - 1;
+    if (*bufferSize < dataBlocks * 16) return STATUS_NO_ROOM;
+
+    unsigned long start = micros();
+    byte result = MIFARE_AuthenticateSector(sector);
+    unsigned long authenticated = micros();
+    byte firstBlock = MIFARE_SectorFirstBlock(sector);
+    byte blocks = 0;
+    while (result == STATUS_OK && blocks < dataBlocks) {
+        byte block[18];
+        byte blockSize = sizeof(block);
+        result = MIFARE_Read(firstBlock + blocks, block, &blockSize);
+        if (result != STATUS_OK) break;
+        memcpy(&buffer[blocks * 16], block, 16);
+        blocks++;
+    }
+
+    if (timing) {
+        timing->sector = sector;
+        timing->status = result;
+        timing->keyIndex = _sectorKey[sector];
+        timing->authUs = authenticated - start;
+        timing->readUs = micros() - authenticated;
+    }
+    *bufferSize = blocks * 16;
+    return result;
+}
+
+// count consecutive sectors into buffer, data blocks only. Stops at the
+// first failing sector; timings (count entries) is filled up to that one.
+template <class Bus>
+byte MFRC522Base<Bus>::MIFARE_ReadSectors(byte firstSector, byte count, byte *buffer,
+                                          uint16_t *bufferSize, SectorTiming *timings) {
+    if (buffer == NULL) return STATUS_INVALID;
+    uint16_t offset = 0;
+    byte result = STATUS_OK;
+    for (byte i = 0; i < count && result == STATUS_OK; i++) {
+        uint16_t room = *bufferSize - offset;
+        byte size = room > 0xFF ? 0xFF : room;
+        result = MIFARE_ReadSector(firstSector + i, &buffer[offset], &size,
+                                   timings ? &timings[i] : NULL);
+        offset += size;
+    }
+    *bufferSize = offset;
+    return result;
+}
+
+template <class Bus>
+byte MFRC522Base<Bus>::MIFARE_TwoStepHelper(byte command, byte blockAddr, long data) {
+    byte cmdBuffer[2] = {command, blockAddr};
+    byte result = PCD_MIFARE_Transceive(cmdBuffer, 2);
+    if (result != STATUS_OK) return result;
+    return PCD_MIFARE_Transceive((byte *)&data, 4, true);
+}
+
+template <class Bus>
+byte MFRC522Base<Bus>::PCD_MIFARE_Transceive(byte *sendData, byte sendLen, bool acceptTimeout) {
+    if (sendData == NULL || sendLen > 16) return STATUS_INVALID;
+    byte cmdBuffer[18];
+    memcpy(cmdBuffer, sendData, sendLen);
+    byte result = PCD_CalculateCRC(cmdBuffer, sendLen, &cmdBuffer[sendLen]);
+    if (result != STATUS_OK) return result;
+    sendLen += 2;
+    PCD_SetTimeoutProfile(PCD_TIMEOUT_MIFARE);
+    byte cmdBufferSize = sizeof(cmdBuffer);
+    byte validBits = 0;
+    result = PCD_CommunicateWithPICC(PCD_Transceive, 0x30, cmdBuffer, sendLen,
+                                     cmdBuffer, &cmdBufferSize, &validBits);
+    if (acceptTimeout && result == STATUS_TIMEOUT) return STATUS_OK;
+    if (result != STATUS_OK) return result;
+    if (cmdBufferSize != 1 || validBits != 4) return STATUS_ERROR;
+    if (cmdBuffer[0] != MF_ACK) return STATUS_MIFARE_NACK;
+    return STATUS_OK;
+}
+
+template <class Bus>
+const __FlashStringHelper *MFRC522Base<Bus>::GetStatusCodeName(byte code) {
+    switch (code) {
+        case STATUS_OK: return F("Success");
+        case STATUS_ERROR: return F("Error");
+        case STATUS_COLLISION: return F("Collision");
+        case STATUS_TIMEOUT: return F("Timeout");
+        case STATUS_NO_ROOM: return F("No room");
+        case STATUS_INTERNAL_ERROR: return F("Internal error");
+        case STATUS_INVALID: return F("Invalid");
+        case STATUS_CRC_WRONG: return F("CRC wrong");
+        case STATUS_MIFARE_NACK: return F("MIFARE NACK");
+        default: return F("Unknown");
+    }
+}
+
+template <class Bus>
+byte MFRC522Base<Bus>::PICC_GetType(byte sak) {
+    if (sak & 0x04) return PICC_TYPE_NOT_COMPLETE;
+    switch (sak) {
+        case 0x09: return PICC_TYPE_MIFARE_MINI;
+        case 0x08: return PICC_TYPE_MIFARE_1K;
+        case 0x18: return PICC_TYPE_MIFARE_4K;
+        case 0x00: return PICC_TYPE_MIFARE_UL;
+        case 0x10: case 0x11: return PICC_TYPE_MIFARE_PLUS;
+        case 0x01: return PICC_TYPE_TNP3XXX;
+    }
+    if (sak & 0x20) return PICC_TYPE_ISO_14443_4;
+    if (sak & 0x40) return PICC_TYPE_ISO_18092;
+    return PICC_TYPE_UNKNOWN;
+}
+
+template <class Bus>
+const __FlashStringHelper *MFRC522Base<Bus>::PICC_GetTypeName(byte piccType) {
+    switch (piccType) {
+        case PICC_TYPE_ISO_14443_4: return F("ISO/IEC 14443-4");
+        case PICC_TYPE_ISO_18092: return F("ISO/IEC 18092 (NFC)");
+        case PICC_TYPE_MIFARE_MINI: return F("MIFARE Mini");
+        case PICC_TYPE_MIFARE_1K: return F("MIFARE 1KB");
+        case PICC_TYPE_MIFARE_4K: return F("MIFARE 4KB");
+        case PICC_TYPE_MIFARE_UL: return F("MIFARE Ultralight");
+        case PICC_TYPE_MIFARE_PLUS: return F("MIFARE Plus");
+        case PICC_TYPE_TNP3XXX: return F("MIFARE TNP3XXX");
+        case PICC_TYPE_NOT_COMPLETE: return F("UID not complete");
+        default: return F("Unknown");
+    }
+}
+
+template <class Bus>
+bool MFRC522Base<Bus>::PICC_IsNewCardPresent() {
+    byte bufferATQA[2];
+    byte bufferSize = sizeof(bufferATQA);
+    byte result = PICC_RequestA(bufferATQA, &bufferSize);
+    return (result == STATUS_OK || result == STATUS_COLLISION);
+}
+
+template <class Bus>
+bool MFRC522Base<Bus>::PICC_ReadCardSerial() {
+    return (PICC_Select(&uid) == STATUS_OK);
+}
+
+// Detection and selection in one call: REQA (or WUPA) goes straight into
+// anticollision. A failed attempt is retried at once with WUPA, which also
+// wakes a tag left HALT by a broken exchange, optionally after cycling the
+// RF field for fieldResetMs. No answer at all returns STATUS_TIMEOUT at once.
+template <class Bus>
+byte MFRC522Base<Bus>::PICC_DetectAndSelect(Uid *uid, bool wakeup, byte retries, byte fieldResetMs) {
+    byte result = STATUS_TIMEOUT;
+    for (byte attempt = 0; attempt <= retries; attempt++) {
+        if (attempt > 0 && fieldResetMs) {
+            PCD_AntennaOff();
+            delay(fieldResetMs);
+            PCD_AntennaOn();
+            delay(fieldResetMs);
+        }
+        byte bufferATQA[2];
+        byte bufferSize = sizeof(bufferATQA);
+        byte command = (wakeup || attempt > 0) ? PICC_CMD_WUPA : PICC_CMD_REQA;
+        result = PICC_REQA_or_WUPA(command, bufferATQA, &bufferSize);
+        if (result == STATUS_TIMEOUT) return result;
+        if (result != STATUS_OK && result != STATUS_COLLISION) continue;
+        memset(uid, 0, sizeof(Uid));
+        result = PICC_Select(uid);
+        if (result == STATUS_OK) return result;
+    }
+    return result;
+}
+
+// Presence check for a tag that was selected then halted: WUPA wakes it,
+// a select on its full UID confirms it is the same tag (others stay silent),
+// HLTA parks it again. STATUS_OK = still in the field, STATUS_TIMEOUT = gone.
+template <class Bus>
+byte MFRC522Base<Bus>::PICC_CheckPresence(const Uid *uid, byte retries) {
+    byte result = STATUS_TIMEOUT;
+    for (byte attempt = 0; attempt <= retries; attempt++) {
+        byte bufferATQA[2];
+        byte bufferSize = sizeof(bufferATQA);
+        result = PICC_REQA_or_WUPA(PICC_CMD_WUPA, bufferATQA, &bufferSize);
+        if (result != STATUS_OK && result != STATUS_COLLISION) continue;
+        Uid target = *uid;
+        result = PICC_Select(&target, target.size * 8);
+        if (result == STATUS_OK) {
+            PICC_HaltA();
+            return result;
+        }
+    }
+    return STATUS_TIMEOUT;
+}
+
+template <class Bus>
+void MFRC522Base<Bus>::PCD_SetLowPowerDetect(uint32_t idleTimeoutMs, uint16_t probePeriodMs, byte settleMs) {
+    _idleTimeoutMs = idleTimeoutMs;
+    _probePeriodMs = probePeriodMs;
+    _probeSettleMs = settleMs;
+    _lastActivity = millis();
+    if (_lowPower && idleTimeoutMs == 0) {
+        PCD_AntennaOn();
+        _lowPower = false;
+    }
+}
+
+// PICC_DetectAndSelect with automatic low-power card detection. After
+// _idleTimeoutMs without any tag the RF field is switched off and only
+// pulsed every _probePeriodMs: field on, _probeSettleMs for the tags to
+// power up, one REQA, field off again. The first answer leaves the mode and
+// keeps the field on. Between probes no I2C traffic at all, and the call
+// returns STATUS_TIMEOUT as if the field were empty.
+template <class Bus>
+byte MFRC522Base<Bus>::PICC_DetectAndSelectLowPower(Uid *uid, byte retries, byte fieldResetMs) {
+    unsigned long now = millis();
+    if (!_lowPower) {
+        byte result = PICC_DetectAndSelect(uid, false, retries, fieldResetMs);
+        if (result != STATUS_TIMEOUT) {
+            _lastActivity = now;
+        } else if (_idleTimeoutMs && now - _lastActivity >= _idleTimeoutMs) {
+            PCD_AntennaOff();
+            _lowPower = true;
+            _lastActivity = now;
+            _lastProbe = now;
+            // New idle window; wakeups keeps counting since PCD_Init
+            _lowPowerStats.idleMs = 0;
+            memset(&_lowPowerStats.idleBus, 0, sizeof(_lowPowerStats.idleBus));
+            _lowPowerStats.probes = 0;
+            _lowPowerStats.lastWakeUs = 0;
+        }
+        return result;
+    }
+
+    if (now - _lastProbe < _probePeriodMs) return STATUS_TIMEOUT;
+    _lastProbe = now;
+    BusStats before = _busStats;
+    unsigned long start = micros();
+    PCD_AntennaOn();
+    delay(_probeSettleMs);
+    byte result = PICC_DetectAndSelect(uid, false, retries, fieldResetMs);
+    _lowPowerStats.probes++;
+    _lowPowerStats.idleBus.transactions += _busStats.transactions - before.transactions;
+    _lowPowerStats.idleBus.bytes += _busStats.bytes - before.bytes;
+    _lowPowerStats.idleBus.errors += _busStats.errors - before.errors;
+
+    if (result == STATUS_TIMEOUT) {
+        PCD_AntennaOff();
+        return result;
+    }
+    _lowPowerStats.lastWakeUs = micros() - start;
+    _lowPowerStats.wakeups++;
+    _lowPowerStats.idleMs = millis() - _lastActivity;
+    _lowPower = false;
+    _lastActivity = millis();
+    return result;
+}
+
+#endif
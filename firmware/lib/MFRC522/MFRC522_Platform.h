@@ -0,0 +1,44 @@
+/**
+ * MFRC522_Platform.h - Arduino primitives used by the MFRC522 driver
+ *
+ * On Arduino this is just <Arduino.h>. In the native build (unit tests) it
+ * provides the same names on top of a virtual clock: delay() advances it,
+ * and every micros()/millis() read advances it by 1 us so that polling
+ * loops against a fake bus always reach their deadline.
+ */
+#ifndef MFRC522_Platform_h
+#define MFRC522_Platform_h
+
+#if defined(ARDUINO)
+#include <Arduino.h>
+#else
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+typedef uint8_t byte;
+typedef uint16_t word;
+
+#define PROGMEM
+#define IRAM_ATTR
+#define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+
+class __FlashStringHelper;
+#define F(str) (reinterpret_cast<const __FlashStringHelper *>(str))
+
+struct MFRC522_Clock {
+    static uint32_t &now() {
+        static uint32_t us = 0;
+        return us;
+    }
+    static void advance(uint32_t us) { now() += us; }
+};
+
+inline unsigned long micros() { return ++MFRC522_Clock::now(); }
+inline unsigned long millis() { return micros() / 1000; }
+inline void delayMicroseconds(unsigned int us) { MFRC522_Clock::advance(us); }
+inline void delay(unsigned long ms) { MFRC522_Clock::advance(ms * 1000); }
+inline void yield() {}
+#endif
+
+#endif
@@ -0,0 +1,710 @@
+/*
+ * MFRC522_Emulator.cpp - Host-side MFRC522 and ISO 14443A tag emulator
+ *
+ * Also instantiates the driver on the emulator: a native test links
+ * MFRC522Base<MFRC522_Emulator> from this unit.
+ */
+
+#if !defined(ARDUINO)
+
+#include "MFRC522_Emulator.h"
+#include "MFRC522_Impl.h"
+
+template class MFRC522Base<MFRC522_Emulator>;
+
+namespace {
+
+const uint32_t CARRIER_KHZ = 13560;
+const uint32_t FDT_CYCLES = 1172;  // PCD frame end -> PICC answer, bit 0 last
+
+const byte RESET_VALUES[][2] = {
+    {MFRC522Defs::CommandReg, 0x20},     {MFRC522Defs::ComIEnReg, 0x80},
+    {MFRC522Defs::ComIrqReg, 0x14},      {MFRC522Defs::Status1Reg, 0x21},
+    {MFRC522Defs::WaterLevelReg, 0x08},  {MFRC522Defs::ControlReg, 0x10},
+    {MFRC522Defs::CollReg, 0xA0},        {MFRC522Defs::ModeReg, 0x3F},
+    {MFRC522Defs::TxControlReg, 0x80},   {MFRC522Defs::TxSelReg, 0x10},
+    {MFRC522Defs::RxSelReg, 0x84},       {MFRC522Defs::RxThresholdReg, 0x84},
+    {MFRC522Defs::DemodReg, 0x4D},       {MFRC522Defs::MfTxReg, 0x62},
+    {MFRC522Defs::SerialSpeedReg, 0xEB}, {MFRC522Defs::CRCResultRegH, 0xFF},
+    {MFRC522Defs::CRCResultRegL, 0xFF},  {MFRC522Defs::ModWidthReg, 0x26},
+    {MFRC522Defs::RFCfgReg, 0x48},       {MFRC522Defs::GsNReg, 0x88},
+    {MFRC522Defs::CWGsPReg, 0x20},       {MFRC522Defs::ModGsPReg, 0x20},
+    {MFRC522Defs::VersionReg, 0x92}};
+
+bool getBit(const byte *buffer, uint16_t index) { return (buffer[index >> 3] >> (index & 7)) & 1; }
+
+void setBit(byte *buffer, uint16_t index, bool value) {
+    if (value) buffer[index >> 3] |= 1 << (index & 7);
+    else buffer[index >> 3] &= ~(1 << (index & 7));
+}
+
+uint32_t cyclesToUs(uint64_t cycles) { return (uint32_t)(cycles * 1000 / CARRIER_KHZ); }
+
+// CRC_A (ISO 14443-3 annex B), bit by bit. Kept apart from MFRC522_CRC so
+// the tests compare the driver's table against an independent reference.
+void crcA(const byte *data, uint16_t length, byte *result) {
+    uint16_t crc = 0x6363;
+    for (uint16_t i = 0; i < length; i++) {
+        crc ^= data[i];
+        for (byte bit = 0; bit < 8; bit++) crc = (crc & 1) ? (crc >> 1) ^ 0x8408 : crc >> 1;
+    }
+    result[0] = crc & 0xFF;
+    result[1] = crc >> 8;
+}
+
+// A frame followed by its own CRC_A leaves a zero residue
+bool crcAValid(const byte *frame, uint16_t length) {
+    if (length < 2) return false;
+    byte crc[2];
+    crcA(frame, length - 2, crc);
+    return crc[0] == frame[length - 2] && crc[1] == frame[length - 1];
+}
+
+}  // namespace
+
+MFRC522_Emulator::MFRC522_Emulator(uint32_t busClockHz)
+    : _busClockHz(busClockHz), _busRemainder(0), _tagCount(0) {
+    resetStats();
+    powerOn();
+}
+
+void MFRC522_Emulator::powerOn() {
+    memset(_regs, 0, sizeof(_regs));
+    for (size_t i = 0; i < sizeof(RESET_VALUES) / sizeof(RESET_VALUES[0]); i++) {
+        _regs[RESET_VALUES[i][0]] = RESET_VALUES[i][1];
+    }
+    _fifoLen = 0;
+    _rxLen = 0;
+    _rxPos = 0;
+    setField(false);
+}
+
+void MFRC522_Emulator::resetStats() {
+    memset(&_stats, 0, sizeof(_stats));
+    _busRemainder = 0;
+}
+
+MFRC522_VirtualTag *MFRC522_Emulator::addTag(MFRC522_VirtualTag::Type type, const byte *uid,
+                                             byte uidSize) {
+    if (_tagCount >= MAX_TAGS) return NULL;
+    if (uidSize != 4 && uidSize != 7 && uidSize != 10) return NULL;
+
+    MFRC522_VirtualTag &t = _tags[_tagCount++];
+    memset(&t, 0, sizeof(t));
+    t.type = type;
+    memcpy(t.uid, uid, uidSize);
+    t.uidSize = uidSize;
+    // ATQA: UID size in bits 7..6, bit frame anticollision
+    t.atqa[0] = (uidSize == 4 ? 0x00 : uidSize == 7 ? 0x40 : 0x80) | 0x04;
+    t.inField = true;
+    t.state = MFRC522_VirtualTag::IDLE;
+    t.authSector = -1;
+    t.pendingWrite = -1;
+
+    switch (type) {
+        case MFRC522_VirtualTag::ULTRALIGHT:
+        case MFRC522_VirtualTag::NTAG215:
+            t.sak = 0x00;
+            t.memorySize = (type == MFRC522_VirtualTag::NTAG215 ? 135 : 16) * 4;
+            if (uidSize == 7) {
+                // Pages 0-2: UID with its two check bytes, internal, lock bytes
+                memcpy(&t.memory[0], uid, 3);
+                t.memory[3] = PICC_CMD_CT ^ uid[0] ^ uid[1] ^ uid[2];
+                memcpy(&t.memory[4], &uid[3], 4);
+                t.memory[8] = uid[3] ^ uid[4] ^ uid[5] ^ uid[6];
+                t.memory[9] = 0x48;
+            } else {
+                memcpy(&t.memory[0], uid, uidSize);
+            }
+            if (type == MFRC522_VirtualTag::NTAG215) {
+                const byte cc[] = {0xE1, 0x10, 0x3E, 0x00};
+                memcpy(&t.memory[12], cc, sizeof(cc));
+            }
+            break;
+        case MFRC522_VirtualTag::CLASSIC_1K:
+            t.sak = 0x08;
+            t.memorySize = 1024;
+            // Block 0: UID, BCC (4-byte UID), SAK, ATQA
+            memcpy(&t.memory[0], uid, uidSize);
+            if (uidSize == 4) t.memory[4] = uid[0] ^ uid[1] ^ uid[2] ^ uid[3];
+            t.memory[uidSize + 1] = t.sak;
+            t.memory[uidSize + 2] = t.atqa[0];
+            t.memory[uidSize + 3] = t.atqa[1];
+            // Sector trailers: transport keys FFFFFFFFFFFF, access bits FF0780
+            for (byte sector = 0; sector < 16; sector++) {
+                byte *trailer = &t.memory[(sector * 4 + 3) * 16];
+                const byte access[] = {0xFF, 0x07, 0x80, 0x69};
+                memset(trailer, 0xFF, 16);
+                memcpy(&trailer[6], access, sizeof(access));
+            }
+            break;
+        case MFRC522_VirtualTag::ISO_14443_4:
+            t.sak = 0x20;
+            t.memorySize = 0;
+            break;
+    }
+    return &t;
+}
+
+// =============================================================================
+// Bus side
+// =============================================================================
+
+void MFRC522_Emulator::write(byte reg, byte count, const byte *values) {
+    refillFifo();
+    // START, address, register, data, STOP; 9 bits per byte with the ACK
+    busTransaction(2 + (2 + count) * 9, 1 + count);
+    for (byte i = 0; i < count; i++) store(reg & 0x3F, values[i]);
+}
+
+void MFRC522_Emulator::read(byte reg, byte count, byte *values) {
+    refillFifo();
+    // START, address, register, repeated START, address, data, STOP
+    busTransaction(3 + (3 + count) * 9, 1 + count);
+    for (byte i = 0; i < count; i++) values[i] = load(reg & 0x3F);
+}
+
+byte MFRC522_Emulator::writeBatch(const byte *batch, byte length) {
+    refillFifo();
+    uint32_t bits = 1;
+    uint32_t bytes = 0;
+    for (byte pos = 0; pos < length; pos += 2 + batch[pos + 1]) {
+        bits += 1 + (2 + batch[pos + 1]) * 9;
+        bytes += 1 + batch[pos + 1];
+    }
+    busTransaction(bits, bytes);
+    for (byte pos = 0; pos < length; pos += 2 + batch[pos + 1]) {
+        for (byte i = 0; i < batch[pos + 1]; i++) store(batch[pos] & 0x3F, batch[pos + 2 + i]);
+    }
+    return 1;
+}
+
+void MFRC522_Emulator::busTransaction(uint32_t bits, uint32_t bytes) {
+    uint64_t scaled = (uint64_t)bits * 1000000 + _busRemainder;
+    uint32_t us = scaled / _busClockHz;
+    _busRemainder = scaled % _busClockHz;
+    _stats.transactions++;
+    _stats.bytes += bytes;
+    _stats.busUs += us;
+    MFRC522_Clock::advance(us);
+}
+
+void MFRC522_Emulator::advance(uint32_t us, bool onAir) {
+    if (onAir) _stats.airUs += us;
+    MFRC522_Clock::advance(us);
+}
+
+void MFRC522_Emulator::store(byte reg, byte value) {
+    switch (reg) {
+        case CommandReg:
+            _regs[reg] = (_regs[reg] & 0x0F) | (value & 0x30);
+            if ((value & 0x0F) != PCD_NoCmdChange) startCommand(value & 0x0F);
+            break;
+        case ComIrqReg:
+        case DivIrqReg:
+            // Set1 selects whether the marked bits are set or cleared
+            if (value & 0x80) _regs[reg] |= value & 0x7F;
+            else _regs[reg] &= ~value;
+            updateAlerts();
+            break;
+        case Status2Reg:
+            // MFCrypto1On can only be cleared by the host
+            _regs[reg] = (_regs[reg] & 0x07) | (_regs[reg] & value & 0x08) | (value & 0xC0);
+            break;
+        case FIFODataReg:
+            fifoPush(value);
+            break;
+        case FIFOLevelReg:
+            if (value & 0x80) {
+                _fifoLen = 0;
+                _rxLen = _rxPos = 0;
+                _regs[ErrorReg] &= ~0x10;
+                updateAlerts();
+            }
+            break;
+        case BitFramingReg:
+            _regs[reg] = value & 0x7F;
+            if ((value & 0x80) && (_regs[CommandReg] & 0x0F) == PCD_Transceive) transceive();
+            break;
+        case CollReg:
+            _regs[reg] = (_regs[reg] & 0x7F) | (value & 0x80);
+            break;
+        case TxControlReg: {
+            bool wasOn = fieldOn();
+            _regs[reg] = value;
+            if (fieldOn() != wasOn) setField(fieldOn());
+            break;
+        }
+        case ErrorReg:
+        case Status1Reg:
+        case ControlReg:  // only the timer start/stop strobes are writable
+        case CRCResultRegH:
+        case CRCResultRegL:
+        case VersionReg:
+            break;
+        default:
+            _regs[reg] = value;
+    }
+}
+
+byte MFRC522_Emulator::load(byte reg) {
+    if (reg == FIFODataReg) {
+        if (_fifoLen == 0) return 0;
+        byte value = _fifo[0];
+        memmove(_fifo, _fifo + 1, --_fifoLen);
+        updateAlerts();
+        return value;
+    }
+    if (reg == FIFOLevelReg) return _fifoLen;
+    return _regs[reg];
+}
+
+void MFRC522_Emulator::fifoPush(byte value) {
+    if (_fifoLen < FIFO_SIZE) _fifo[_fifoLen++] = value;
+    else _regs[ErrorReg] |= 0x10;  // BufferOvfl
+    updateAlerts();
+}
+
+// The tag keeps sending while the host is busy: before each transaction the
+// FIFO takes as much of the pending reception as it has room for. RxIRq
+// fires once the last byte is in.
+void MFRC522_Emulator::refillFifo() {
+    if (_rxPos >= _rxLen) return;
+    while (_fifoLen < FIFO_SIZE && _rxPos < _rxLen) _fifo[_fifoLen++] = _rx[_rxPos++];
+    if (_rxPos >= _rxLen) {
+        _rxLen = _rxPos = 0;
+        _regs[ComIrqReg] |= 0x20;
+    }
+    updateAlerts();
+}
+
+// HiAlert / LoAlert are levels; their IRQ bits are set again as long as the
+// level holds, so clearing them while the FIFO is still full has no effect.
+void MFRC522_Emulator::updateAlerts() {
+    byte waterLevel = _regs[WaterLevelReg] & 0x3F;
+    bool hiAlert = FIFO_SIZE - _fifoLen <= waterLevel;
+    bool loAlert = _fifoLen <= waterLevel;
+    _regs[Status1Reg] = (_regs[Status1Reg] & ~0x03) | (hiAlert ? 0x02 : 0) | (loAlert ? 0x01 : 0);
+    if (hiAlert) _regs[ComIrqReg] |= 0x08;
+    if (loAlert) _regs[ComIrqReg] |= 0x04;
+}
+
+// Tags are powered by the field: switching it off resets every one of them.
+void MFRC522_Emulator::setField(bool on) {
+    if (on) return;
+    for (byte i = 0; i < _tagCount; i++) {
+        reject(_tags[i]);
+        _tags[i].state = MFRC522_VirtualTag::IDLE;
+        _tags[i].fromHalt = false;
+    }
+}
+
+// =============================================================================
+// Commands
+// =============================================================================
+
+void MFRC522_Emulator::startCommand(byte command) {
+    _regs[CommandReg] = (_regs[CommandReg] & 0x30) | command;
+    switch (command) {
+        case PCD_Mem:
+            _fifoLen = 0;
+            _regs[CommandReg] &= 0x30;
+            break;
+        case PCD_CalcCRC:
+            if ((_regs[AutoTestReg] & 0x0F) == 0x09) {
+                // Digital self test: the FIFO receives the reference pattern
+                memcpy(_fifo, MFRC522_firmware_referenceV2_0, FIFO_SIZE);
+                _fifoLen = FIFO_SIZE;
+            } else {
+                byte crc[2];
+                crcA(_fifo, _fifoLen, crc);
+                _regs[CRCResultRegL] = crc[0];
+                _regs[CRCResultRegH] = crc[1];
+                _fifoLen = 0;
+            }
+            _regs[Status1Reg] |= 0x20;  // CRCReady
+            _regs[DivIrqReg] |= 0x04;   // CRCIRq
+            updateAlerts();
+            break;
+        case PCD_MFAuthent:
+            authenticate();
+            break;
+        case PCD_SoftReset:
+            powerOn();
+            break;
+        case PCD_Transceive:
+            break;  // waits for StartSend
+        default:
+            _regs[CommandReg] &= 0x30;  // not emulated: back to Idle
+    }
+}
+
+void MFRC522_Emulator::transceive() {
+    byte frame[FIFO_SIZE];
+    byte length = _fifoLen;
+    memcpy(frame, _fifo, length);
+    _fifoLen = 0;
+    _rxLen = _rxPos = 0;
+
+    byte txLastBits = _regs[BitFramingReg] & 0x07;
+    byte rxAlign = (_regs[BitFramingReg] >> 4) & 0x07;
+    uint16_t bits = length ? (length - (txLastBits ? 1 : 0)) * 8 + txLastBits : 0;
+    _regs[ErrorReg] = 0;
+    _regs[CollReg] = (_regs[CollReg] & 0x80) | 0x20;
+    _regs[ControlReg] &= ~0x07;
+    _stats.frames++;
+    if (bits == 7 && frame[0] == PICC_CMD_WUPA) _stats.wakeups++;
+    advance(frameUs(bits, (_regs[TxModeReg] >> 4) & 0x07), true);
+
+    // Every tag answers in the same slot; the first bit where two answers
+    // differ is a collision, and the bits from there on read as 0.
+    byte merged[RX_SIZE];
+    byte answer[RX_SIZE];
+    uint16_t mergedBits = 0;
+    uint16_t knownBits = 0;
+    uint16_t collisionAt = 0xFFFF;
+    byte responders = 0;
+    for (byte i = 0; fieldOn() && i < _tagCount; i++) {
+        uint16_t known = 0;
+        memset(answer, 0, sizeof(answer));
+        uint16_t n = respond(_tags[i], frame, bits, answer, &known);
+        if (n == 0) continue;
+        if (responders++ == 0) {
+            memcpy(merged, answer, sizeof(merged));
+            mergedBits = n;
+            knownBits = known;
+            continue;
+        }
+        uint16_t common = n < mergedBits ? n : mergedBits;
+        uint16_t at = common;
+        if (n == mergedBits) at = 0xFFFF;
+        for (uint16_t bit = 0; bit < common; bit++) {
+            if (getBit(merged, bit) != getBit(answer, bit)) {
+                at = bit;
+                break;
+            }
+        }
+        if (at < collisionAt) collisionAt = at;
+        for (uint16_t bit = mergedBits; bit < n; bit++) setBit(merged, bit, getBit(answer, bit));
+        if (n > mergedBits) mergedBits = n;
+    }
+
+    if (responders == 0) {
+        // No answer: the timer (TAuto) runs out and raises TimerIRq
+        if (_regs[TModeReg] & 0x80) {
+            advance(timerUs(), true);
+            _regs[ComIrqReg] |= 0x01;
+        }
+        return;
+    }
+
+    advance(cyclesToUs(FDT_CYCLES) + frameUs(mergedBits, (_regs[RxModeReg] >> 4) & 0x07), true);
+    if (collisionAt != 0xFFFF) {
+        for (uint16_t bit = collisionAt; bit < mergedBits; bit++) setBit(merged, bit, false);
+        // CollPos counts from the first bit of the cascade level's UID
+        // field, 1-based; 32 reads as 0.
+        uint16_t position = knownBits + collisionAt + 1;
+        _regs[ErrorReg] |= 0x08;
+        _regs[CollReg] = (_regs[CollReg] & 0x80) | (position > 32 ? 0x20 : position & 0x1F);
+    }
+
+    // Received bits land in the FIFO from bit rxAlign of the first byte
+    uint16_t total = rxAlign + mergedBits;
+    memset(_rx, 0, sizeof(_rx));
+    for (uint16_t bit = 0; bit < mergedBits; bit++) setBit(_rx, rxAlign + bit, getBit(merged, bit));
+    _rxLen = (total + 7) / 8;
+    _rxPos = 0;
+    _regs[ControlReg] |= total % 8;
+    refillFifo();
+}
+
+// MFAuthent: FIFO holds command, block, 6-byte key, 4 UID bytes. Success
+// sets MFCrypto1On and IdleIRq; a wrong key or no tag ends in a timeout.
+void MFRC522_Emulator::authenticate() {
+    byte frame[FIFO_SIZE];
+    byte length = _fifoLen;
+    memcpy(frame, _fifo, length);
+    _fifoLen = 0;
+    _regs[ErrorReg] = 0;
+    _regs[CommandReg] &= 0x30;
+    _stats.frames++;
+    advance(frameUs(32, 0), true);
+
+    MFRC522_VirtualTag *target = NULL;
+    for (byte i = 0; fieldOn() && length == 12 && i < _tagCount; i++) {
+        MFRC522_VirtualTag &t = _tags[i];
+        if (!t.inField || t.state != MFRC522_VirtualTag::ACTIVE) continue;
+        if (t.type != MFRC522_VirtualTag::CLASSIC_1K || memcmp(t.uid, &frame[8], 4) != 0) continue;
+        if (t.ignoreFrames) {
+            t.ignoreFrames--;
+            continue;
+        }
+        target = &t;
+    }
+
+    bool authenticated = false;
+    if (target && frame[1] < 64 &&
+        (frame[0] == PICC_CMD_MF_AUTH_KEY_A || frame[0] == PICC_CMD_MF_AUTH_KEY_B)) {
+        byte sector = frame[1] / 4;
+        const byte *trailer = &target->memory[(sector * 4 + 3) * 16];
+        const byte *key = frame[0] == PICC_CMD_MF_AUTH_KEY_A ? trailer : &trailer[10];
+        authenticated = memcmp(key, &frame[2], MF_KEY_SIZE) == 0;
+        if (authenticated) target->authSector = sector;
+        else reject(*target);
+    }
+
+    if (!authenticated) {
+        if (_regs[TModeReg] & 0x80) {
+            advance(timerUs(), true);
+            _regs[ComIrqReg] |= 0x01;
+        }
+        return;
+    }
+    // Tag nonce, reader nonce + answer, tag answer
+    advance(3 * cyclesToUs(FDT_CYCLES) + frameUs(32, 0) + frameUs(64, 0) + frameUs(32, 0), true);
+    _regs[Status2Reg] |= 0x08;
+    _regs[ComIrqReg] |= 0x10;
+}
+
+// TAuto timer period: (TReload + 1) ticks of (2 * TPrescaler + 1) cycles
+uint32_t MFRC522_Emulator::timerUs() const {
+    uint32_t prescaler = ((_regs[TModeReg] & 0x0F) << 8) | _regs[TPrescalerReg];
+    uint32_t reload = (_regs[TReloadRegH] << 8) | _regs[TReloadRegL];
+    return cyclesToUs((uint64_t)(reload + 1) * (2 * prescaler + 1));
+}
+
+// Air time of a frame: a parity bit per full byte, start and end of frame,
+// 128 carrier cycles per bit at 106 kbps.
+uint32_t MFRC522_Emulator::frameUs(uint16_t bits, byte rate) const {
+    uint32_t onAir = (bits / 8) * 9 + bits % 8 + 2;
+    return cyclesToUs((uint64_t)onAir * (128 >> (rate & 0x03)));
+}
+
+// =============================================================================
+// Virtual tags
+// =============================================================================
+
+// Answer of one tag to a PCD frame, bit-packed from out[0] bit 0. Returns
+// the number of bits, 0 for no answer. *knownBits is the number of UID bits
+// the PCD already sent (anticollision), 0 otherwise.
+uint16_t MFRC522_Emulator::respond(MFRC522_VirtualTag &t, const byte *frame, uint16_t bits,
+                                   byte *out, uint16_t *knownBits) {
+    *knownBits = 0;
+    if (!t.inField || bits == 0) return 0;
+    if (t.ignoreFrames) {
+        t.ignoreFrames--;
+        return 0;
+    }
+
+    if (bits == 7) {
+        byte command = frame[0] & 0x7F;
+        bool wakes = (command == PICC_CMD_REQA && t.state == MFRC522_VirtualTag::IDLE) ||
+                     (command == PICC_CMD_WUPA && (t.state == MFRC522_VirtualTag::IDLE ||
+                                                   t.state == MFRC522_VirtualTag::HALT));
+        if (wakes) {
+            t.fromHalt = t.state == MFRC522_VirtualTag::HALT;
+            t.state = MFRC522_VirtualTag::READY;
+            t.cascadeLevel = 1;
+            out[0] = t.atqa[0];
+            out[1] = t.atqa[1];
+            return 16;
+        }
+        if (t.state == MFRC522_VirtualTag::READY || t.state == MFRC522_VirtualTag::ACTIVE) reject(t);
+        return 0;
+    }
+
+    if (t.state == MFRC522_VirtualTag::READY) return respondSelect(t, frame, bits, out, knownBits);
+    if (t.state != MFRC522_VirtualTag::ACTIVE) return 0;
+
+    // Frames with a bad CRC are ignored, without a state change
+    if (bits % 8 || bits < 24 || !crcAValid(frame, bits / 8)) return 0;
+    // Crypto1 on one side only: the tag sees noise
+    bool crypto = (_regs[Status2Reg] & 0x08) != 0;
+    if ((t.authSector >= 0) != crypto) {
+        reject(t);
+        return 0;
+    }
+    return respondActive(t, frame, bits / 8 - 2, out);
+}
+
+// SELECT / ANTICOLLISION of the current cascade level. The level's UID
+// field is 4 UID bytes, or CT + 3 when more levels follow, then the BCC.
+uint16_t MFRC522_Emulator::respondSelect(MFRC522_VirtualTag &t, const byte *frame, uint16_t bits,
+                                         byte *out, uint16_t *knownBits) {
+    byte level = frame[0] == PICC_CMD_SEL_CL1   ? 1
+                 : frame[0] == PICC_CMD_SEL_CL2 ? 2
+                 : frame[0] == PICC_CMD_SEL_CL3 ? 3
+                                                : 0;
+    if (level == 0 || level != t.cascadeLevel || bits < 16) {
+        reject(t);
+        return 0;
+    }
+
+    byte levels = t.uidSize == 4 ? 1 : t.uidSize == 7 ? 2 : 3;
+    const byte *part = &t.uid[(level - 1) * 3];
+    byte field[5];
+    if (level < levels) {
+        field[0] = PICC_CMD_CT;
+        memcpy(&field[1], part, 3);
+    } else {
+        memcpy(field, part, 4);
+    }
+    field[4] = field[0] ^ field[1] ^ field[2] ^ field[3];
+
+    byte nvb = frame[1];
+    if (nvb == 0x70) {
+        if (bits != 72 || !crcAValid(frame, 9) || memcmp(&frame[2], field, 5) != 0) {
+            reject(t);
+            return 0;
+        }
+        if (level < levels) {
+            t.cascadeLevel++;
+            out[0] = 0x04;  // cascade bit: UID not complete
+        } else {
+            t.state = MFRC522_VirtualTag::ACTIVE;
+            out[0] = t.sak;
+        }
+        if (t.lostSelects) {
+            t.lostSelects--;  // selected, but the answer never reaches the PCD
+            return 0;
+        }
+        return withCrc(out, 1);
+    }
+
+    uint16_t known = ((nvb >> 4) - 2) * 8 + (nvb & 0x0F);
+    if ((nvb >> 4) < 2 || known > 32 || bits != (nvb >> 4) * 8 + (nvb & 0x0F)) {
+        reject(t);
+        return 0;
+    }
+    for (uint16_t bit = 0; bit < known; bit++) {
+        if (getBit(&frame[2], bit) != getBit(field, bit)) return 0;  // not me, stay READY
+    }
+    for (uint16_t bit = known; bit < 40; bit++) setBit(out, bit - known, getBit(field, bit));
+    *knownBits = known;
+    return 40 - known;
+}
+
+// Commands of a selected tag; length excludes the CRC_A.
+uint16_t MFRC522_Emulator::respondActive(MFRC522_VirtualTag &t, const byte *frame, byte length,
+                                         byte *out) {
+    bool classic = t.type == MFRC522_VirtualTag::CLASSIC_1K;
+    byte command = frame[0];
+
+    if (t.pendingWrite >= 0) {
+        int16_t block = t.pendingWrite;
+        t.pendingWrite = -1;
+        if (length != 16) {
+            reject(t);
+            return 0;
+        }
+        // Ultralight compatibility WRITE keeps the first 4 bytes
+        memcpy(&t.memory[block * (classic ? 16 : 4)], frame, classic ? 16 : 4);
+        return ack(out);
+    }
+
+    if (command == PICC_CMD_HLTA && length == 2 && frame[1] == 0) {
+        t.state = MFRC522_VirtualTag::HALT;
+        t.authSector = -1;
+        return 0;
+    }
+
+    if (t.type == MFRC522_VirtualTag::ISO_14443_4) {
+        if (command == PICC_CMD_RATS && length == 2) {
+            // ATS: TL, T0 (TA1 TB1 TC1 present, FSCI 8), TA1, TB1, TC1
+            out[0] = 0x05;
+            out[1] = 0x78;
+            out[2] = t.atsTa1;
+            out[3] = 0x80;
+            out[4] = 0x02;
+            return withCrc(out, 5);
+        }
+        if ((command & 0xF0) == PICC_CMD_PPS && length == 3) {
+            out[0] = command;
+            return withCrc(out, 1);
+        }
+        if ((command & 0xE2) == 0x02) {  // I-block: answer 90 00
+            out[0] = command;
+            out[1] = 0x90;
+            out[2] = 0x00;
+            return withCrc(out, 3);
+        }
+        if (command == 0xC2 && length == 1) {  // S(DESELECT)
+            t.state = MFRC522_VirtualTag::HALT;
+            out[0] = command;
+            return withCrc(out, 1);
+        }
+        reject(t);
+        return 0;
+    }
+
+    switch (command) {
+        case PICC_CMD_MF_READ: {
+            if (length != 2) break;
+            byte addr = frame[1];
+            if (t.nackReads) break;
+            if (classic) {
+                if (addr >= 64 || t.authSector != addr / 4) break;
+                memcpy(out, &t.memory[addr * 16], 16);
+                if (addr % 4 == 3) memset(out, 0, MF_KEY_SIZE);  // key A never reads back
+            } else {
+                if (addr * 4 >= t.memorySize) break;
+                // 4 pages, rolling over to page 0
+                for (byte i = 0; i < 16; i++) out[i] = t.memory[(addr * 4 + i) % t.memorySize];
+            }
+            return withCrc(out, 16);
+        }
+        case PICC_CMD_UL_FAST_READ: {
+            if (length != 3 || t.type != MFRC522_VirtualTag::NTAG215 || t.nackReads) break;
+            byte start = frame[1];
+            byte end = frame[2];
+            if (end < start || (end + 1) * 4 > t.memorySize) break;
+            uint16_t count = (end - start + 1) * 4;
+            memcpy(out, &t.memory[start * 4], count);
+            return withCrc(out, count);
+        }
+        case PICC_CMD_UL_WRITE: {
+            if (length != 6 || classic) break;
+            byte page = frame[1];
+            if (page < 2 || (page + 1) * 4 > t.memorySize) break;
+            memcpy(&t.memory[page * 4], &frame[2], 4);
+            return ack(out);
+        }
+        case PICC_CMD_MF_WRITE: {
+            if (length != 2) break;
+            byte addr = frame[1];
+            if (classic && (addr == 0 || addr >= 64 || t.authSector != addr / 4)) break;
+            if (!classic && (addr < 2 || (addr + 1) * 4 > t.memorySize)) break;
+            t.pendingWrite = addr;
+            return ack(out);
+        }
+    }
+    // Anything else is answered with a NAK, and the tag drops back
+    reject(t);
+    return nak(out);
+}
+
+void MFRC522_Emulator::reject(MFRC522_VirtualTag &t) {
+    if (t.state == MFRC522_VirtualTag::READY || t.state == MFRC522_VirtualTag::ACTIVE) {
+        t.state = t.fromHalt ? MFRC522_VirtualTag::HALT : MFRC522_VirtualTag::IDLE;
+    }
+    t.cascadeLevel = 0;
+    t.authSector = -1;
+    t.pendingWrite = -1;
+}
+
+uint16_t MFRC522_Emulator::withCrc(byte *out, uint16_t length) {
+    crcA(out, length, &out[length]);
+    return (length + 2) * 8;
+}
+
+uint16_t MFRC522_Emulator::nak(byte *out) {
+    out[0] = 0x0;
+    return 4;
+}
+
+uint16_t MFRC522_Emulator::ack(byte *out) {
+    out[0] = MF_ACK;
+    return 4;
+}
+
+#endif
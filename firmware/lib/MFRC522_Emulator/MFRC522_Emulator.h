@@ -0,0 +1,139 @@
+/**
+ * MFRC522_Emulator.h - Host-side MFRC522 and ISO 14443A tag emulator
+ *
+ * A bus policy for MFRC522Base<Bus> that behaves like the chip instead of a
+ * bare register file: 64-byte FIFO with water-level alerts, Set1 IRQ
+ * registers, the timer, the CRC coprocessor, Transceive / MFAuthent /
+ * CalcCRC / SoftReset, and an RF field holding up to MAX_TAGS virtual tags.
+ * Tags follow the ISO 14443-3 state machine (IDLE, READY, ACTIVE, HALT)
+ * with 4, 7 or 10-byte UIDs, bit-exact anticollision and collisions, and
+ * carry Ultralight / NTAG or Classic 1K memory. Faults are set per tag:
+ * NAK every read, ignore the next N frames, lose the next N SELECT
+ * answers, leave the field.
+ *
+ * Time is simulated: every bus transaction and every frame on air advances
+ * MFRC522_Clock, and stats() keeps the totals, so a driver change can be
+ * measured by transaction count and bus time without hardware.
+ *
+ * Simplifications: frames are sent whole at StartSend (at most one FIFO),
+ * Crypto1 is not applied to the data, and the receiver settings
+ * (gain, thresholds) do not affect reception. Native builds only.
+ */
+#ifndef MFRC522_Emulator_h
+#define MFRC522_Emulator_h
+
+#if !defined(ARDUINO)
+
+#include "MFRC522_I2C.h"
+
+struct MFRC522_VirtualTag {
+    enum Type { ULTRALIGHT, NTAG215, CLASSIC_1K, ISO_14443_4 };
+    enum State { IDLE, READY, ACTIVE, HALT };
+    static const uint16_t MEMORY_SIZE = 1024;
+
+    Type type;
+    byte uid[10];
+    byte uidSize;
+    byte sak;
+    byte atqa[2];
+    byte atsTa1;              // ISO 14443-4: bit rates offered in the ATS
+    byte memory[MEMORY_SIZE];  // pages (Ultralight) or blocks (Classic)
+    uint16_t memorySize;
+
+    // Faults, set freely by the test
+    bool inField;
+    bool nackReads;     // READ / FAST_READ answer NAK
+    byte ignoreFrames;  // the next frames get no answer (timeouts)
+    byte lostSelects;   // the next SELECTs are obeyed but their answer is lost
+
+    // Protocol state, driven by the emulator
+    State state;
+    bool fromHalt;  // woken by WUPA: an error sends it back to HALT
+    byte cascadeLevel;
+    int8_t authSector;
+    int16_t pendingWrite;  // block of a two-step WRITE waiting for its data
+};
+
+class MFRC522_Emulator : public MFRC522Defs {
+   public:
+    static const byte MAX_TAGS = 4;
+    static const uint16_t RX_SIZE = 1100;
+
+    typedef struct {
+        uint32_t transactions;
+        uint32_t bytes;   // register address + data, like BusStats
+        uint32_t busUs;   // time the host spent on the bus
+        uint32_t airUs;   // frames on air, frame delay and timer expiry
+        uint32_t frames;  // PCD frames sent
+        uint32_t wakeups; // WUPA among them
+    } Stats;
+
+    // busClockHz: I2C clock used to price each transaction.
+    explicit MFRC522_Emulator(uint32_t busClockHz = 100000);
+
+    // Chip power-on: registers to their reset values, field off.
+    void powerOn();
+
+    // Puts a tag in the field (4, 7 or 10-byte UID) with its memory laid
+    // out like the real part. NULL if the field is full or the size invalid.
+    MFRC522_VirtualTag *addTag(MFRC522_VirtualTag::Type type, const byte *uid, byte uidSize);
+    void removeTags() { _tagCount = 0; }
+    byte tagCount() const { return _tagCount; }
+    MFRC522_VirtualTag &tag(byte index) { return _tags[index]; }
+
+    bool fieldOn() const { return (_regs[TxControlReg] & 0x03) != 0; }
+    byte registerValue(byte reg) const { return _regs[reg & 0x3F]; }
+
+    const Stats &stats() const { return _stats; }
+    void resetStats();
+
+    // Bus policy interface (MFRC522_Bus.h); a batch is one transaction,
+    // like the ESP32 repeated-START frame.
+    void write(byte reg, byte count, const byte *values);
+    void read(byte reg, byte count, byte *values);
+    byte writeBatch(const byte *batch, byte length);
+
+   private:
+    uint32_t _busClockHz;
+    uint32_t _busRemainder;
+    Stats _stats;
+
+    byte _regs[0x40];
+    byte _fifo[FIFO_SIZE];
+    byte _fifoLen;
+    // Reception longer than the FIFO: the rest arrives as the host drains it
+    byte _rx[RX_SIZE];
+    uint16_t _rxLen;
+    uint16_t _rxPos;
+
+    MFRC522_VirtualTag _tags[MAX_TAGS];
+    byte _tagCount;
+
+    void busTransaction(uint32_t bits, uint32_t bytes);
+    void advance(uint32_t us, bool onAir);
+    void store(byte reg, byte value);
+    byte load(byte reg);
+    void fifoPush(byte value);
+    void refillFifo();
+    void updateAlerts();
+    void setField(bool on);
+
+    void startCommand(byte command);
+    void transceive();
+    void authenticate();
+    uint32_t timerUs() const;
+    uint32_t frameUs(uint16_t bits, byte rate) const;
+
+    uint16_t respond(MFRC522_VirtualTag &t, const byte *frame, uint16_t bits,
+                     byte *out, uint16_t *knownBits);
+    uint16_t respondSelect(MFRC522_VirtualTag &t, const byte *frame, uint16_t bits,
+                           byte *out, uint16_t *knownBits);
+    uint16_t respondActive(MFRC522_VirtualTag &t, const byte *frame, byte length, byte *out);
+    static void reject(MFRC522_VirtualTag &t);
+    static uint16_t withCrc(byte *out, uint16_t length);
+    static uint16_t nak(byte *out);
+    static uint16_t ack(byte *out);
+};
+
+#endif
+#endif
@@ -0,0 +1,140 @@
+/**
+ * GrblStatus.h - GRBL 1.1 real-time status report
+ *
+ * Parses the answer to '?':
+ *   <Run|MPos:0.000,0.000,12.500|Bf:14,112|FS:20,0|Ov:100,100,100>
+ * Fields missing from a report keep their last value (GRBL sends WCO and Ov
+ * only every few reports). A report with WPos instead of MPos is turned
+ * back into machine position with the last WCO. Unknown fields are skipped.
+ * No Arduino dependency.
+ */
+#ifndef GrblStatus_h
+#define GrblStatus_h
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct GrblStatus {
+    enum State { UNKNOWN, IDLE, RUN, HOLD, JOG, ALARM, DOOR, CHECK, HOME, SLEEP };
+
+    State state;
+    uint8_t subState;   // Hold:0 = stopped, Hold:1 = decelerating, Door:n
+    float mpos[3];      // machine position X, Y, Z (mm)
+    float wco[3];       // work coordinate offset
+    float feed;         // actual feed rate (mm/min)
+    uint16_t spindle;
+    int16_t plannerFree;  // Bf: free planner blocks (-1 = not reported)
+    int16_t rxFree;       // Bf: free bytes in the serial RX buffer
+    uint8_t feedOverride;
+    uint8_t rapidOverride;
+    uint8_t spindleOverride;
+    uint32_t reports;   // reports parsed so far
+
+    GrblStatus() { clear(); }
+
+    void clear() {
+        memset(this, 0, sizeof(*this));
+        plannerFree = rxFree = -1;
+        feedOverride = rapidOverride = spindleOverride = 100;
+    }
+
+    // Stopped: nothing moving, nothing left to run.
+    bool stopped() const { return state == IDLE || (state == HOLD && subState == 0); }
+
+    // false if the line is not a status report (nothing changed).
+    bool parse(const char *line) {
+        size_t length = strlen(line);
+        if (length < 3 || line[0] != '<' || line[length - 1] != '>') return false;
+
+        const char *field = line + 1;
+        const char *end = line + length - 1;
+        bool first = true;
+        while (field < end) {
+            const char *next = (const char *)memchr(field, '|', end - field);
+            if (next == NULL) next = end;
+            if (first) {
+                parseState(field, next - field);
+                first = false;
+            } else if (startsWith(field, "MPos:")) {
+                parseFloats(field + 5, mpos, 3);
+            } else if (startsWith(field, "WPos:")) {
+                float wpos[3];
+                if (parseFloats(field + 5, wpos, 3)) {
+                    for (uint8_t i = 0; i < 3; i++) mpos[i] = wpos[i] + wco[i];
+                }
+            } else if (startsWith(field, "WCO:")) {
+                parseFloats(field + 4, wco, 3);
+            } else if (startsWith(field, "FS:")) {
+                float values[2];
+                if (parseFloats(field + 3, values, 2)) {
+                    feed = values[0];
+                    spindle = (uint16_t)values[1];
+                }
+            } else if (startsWith(field, "F:")) {
+                parseFloats(field + 2, &feed, 1);
+            } else if (startsWith(field, "Bf:")) {
+                float values[2];
+                if (parseFloats(field + 3, values, 2)) {
+                    plannerFree = (int16_t)values[0];
+                    rxFree = (int16_t)values[1];
+                }
+            } else if (startsWith(field, "Ov:")) {
+                float values[3];
+                if (parseFloats(field + 3, values, 3)) {
+                    feedOverride = (uint8_t)values[0];
+                    rapidOverride = (uint8_t)values[1];
+                    spindleOverride = (uint8_t)values[2];
+                }
+            }
+            field = next + 1;
+        }
+        reports++;
+        return true;
+    }
+
+    static const char *stateName(State state) {
+        static const char *const NAMES[] = {"?", "Idle", "Run", "Hold", "Jog",
+                                            "Alarm", "Door", "Check", "Home", "Sleep"};
+        return NAMES[state];
+    }
+
+   private:
+    static bool startsWith(const char *field, const char *prefix) {
+        return strncmp(field, prefix, strlen(prefix)) == 0;
+    }
+
+    void parseState(const char *field, size_t length) {
+        static const char *const NAMES[] = {"Idle", "Run", "Hold", "Jog", "Alarm",
+                                            "Door", "Check", "Home", "Sleep"};
+        const char *colon = (const char *)memchr(field, ':', length);
+        size_t nameLength = colon ? (size_t)(colon - field) : length;
+        state = UNKNOWN;
+        subState = 0;
+        for (uint8_t i = 0; i < sizeof(NAMES) / sizeof(NAMES[0]); i++) {
+            if (strlen(NAMES[i]) == nameLength && strncmp(field, NAMES[i], nameLength) == 0) {
+                state = (State)(i + 1);
+                break;
+            }
+        }
+        if (colon) subState = (uint8_t)atoi(colon + 1);
+    }
+
+    // Reads count comma-separated numbers; out is left untouched if one is missing.
+    static bool parseFloats(const char *text, float *out, uint8_t count) {
+        float values[3];
+        char *end;
+        for (uint8_t i = 0; i < count; i++) {
+            values[i] = (float)strtod(text, &end);
+            if (end == text) return false;
+            if (i + 1 < count) {
+                if (*end != ',') return false;
+                text = end + 1;
+            }
+        }
+        memcpy(out, values, count * sizeof(float));
+        return true;
+    }
+};
+
+#endif
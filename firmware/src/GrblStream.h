@@ -0,0 +1,210 @@
+/**
+ * GrblStream.h - Character-counting G-code sender for GRBL
+ *
+ * GRBL acknowledges every line with "ok" or "error:N" once it has left its
+ * 128-byte serial RX buffer. The sender keeps the length of each line sent
+ * and not yet acknowledged, and sends the next queued line as soon as it
+ * fits in what is left of that buffer: the planner stays fed without
+ * waiting for each reply and without fixed delays.
+ *
+ * Link policy (the transport), same role as the MFRC522 bus policies:
+ *   void write(const char *data, uint8_t length);
+ *   uint8_t read(char *buffer, uint8_t size);   // bytes received, 0 if none
+ * Bytes outside printable ASCII (I2C padding) are ignored, lines end at '\n'.
+ *
+ * Replies: ok / error:N acknowledge the oldest line in flight, ALARM:N is
+ * counted and kept, the "Grbl x.y" banner (after a reset) is flagged, any
+ * other line (status report, [MSG:...]) goes to the line handler.
+ * No Arduino dependency, the caller provides the clock (microseconds).
+ */
+#ifndef GrblStream_h
+#define GrblStream_h
+
+#include <stdint.h>
+#include <string.h>
+#include <stdlib.h>
+
+template <class Link, uint8_t Depth = 16>
+class GrblStream {
+   public:
+    static const uint8_t RX_BUFFER_SIZE = 128;  // GRBL serial RX buffer
+    static const uint8_t LINE_SIZE = 48;        // longest line + '\n'
+    static const uint8_t REPLY_SIZE = 80;
+
+    typedef void (*LineHandler)(const char *line, void *context);
+
+    typedef struct {
+        uint32_t sent;         // lines sent
+        uint32_t acked;        // ... acknowledged (ok or error)
+        uint32_t errors;       // error:N replies
+        uint32_t alarms;       // ALARM:N messages
+        uint32_t lastLatencyUs;  // send -> ack of the last line
+        uint32_t maxLatencyUs;
+        uint64_t totalLatencyUs;
+        uint8_t maxDepth;      // lines queued + in flight, high-water mark
+        uint8_t maxInFlight;   // bytes in the GRBL RX buffer, high-water mark
+    } Stats;
+
+    explicit GrblStream(const Link &link)
+        : _link(link), _handler(NULL), _handlerContext(NULL) {
+        resetStats();
+        reset();
+    }
+
+    Link &link() { return _link; }
+    void setLineHandler(LineHandler handler, void *context = NULL) {
+        _handler = handler;
+        _handlerContext = context;
+    }
+
+    // Queues a line (no line ending) and sends what fits. false if the line
+    // is too long or the queue is full: call poll() and retry.
+    bool send(const char *line, uint32_t nowUs) {
+        size_t length = strlen(line);
+        if (length + 1 > LINE_SIZE || _count == Depth) return false;
+        Entry &entry = _entries[(_head + _count) % Depth];
+        memcpy(entry.text, line, length);
+        entry.text[length] = '\n';
+        entry.length = length + 1;
+        _count++;
+        if (_count > _stats.maxDepth) _stats.maxDepth = _count;
+        pump(nowUs);
+        return true;
+    }
+
+    // Real-time command (single byte, bypasses the RX buffer and the queue).
+    void realtime(char command) { _link.write(&command, 1); }
+    // Several real-time commands in one link write (e.g. override steps).
+    void realtime(const char *commands, uint8_t count) {
+        if (count > 0) _link.write(commands, count);
+    }
+
+    // Reads and parses the replies, then sends the queued lines that now fit.
+    void poll(uint32_t nowUs) {
+        char buffer[32];
+        uint8_t received = _link.read(buffer, sizeof(buffer));
+        for (uint8_t i = 0; i < received; i++) receive(buffer[i], nowUs);
+        pump(nowUs);
+    }
+
+    // Nothing queued or waiting for its ack.
+    bool idle() const { return _count == 0; }
+    uint8_t depth() const { return _count; }
+    uint8_t inFlight() const { return _inFlightBytes; }
+
+    // After a soft reset (0x18): GRBL drops its buffer, so do we.
+    void reset() {
+        _head = _count = _sentCount = 0;
+        _inFlightBytes = 0;
+        _replyLength = 0;
+        _bannerSeen = false;
+    }
+    bool bannerSeen() const { return _bannerSeen; }
+
+    int lastError() const { return _lastError; }
+    int lastAlarm() const { return _lastAlarm; }
+    // Line that got the last error:N (empty if none).
+    const char *lastErrorLine() const { return _lastErrorLine; }
+
+    const Stats &stats() const { return _stats; }
+    void resetStats() {
+        memset(&_stats, 0, sizeof(_stats));
+        _lastError = _lastAlarm = 0;
+        _lastErrorLine[0] = '\0';
+    }
+    uint32_t averageLatencyUs() const {
+        return _stats.acked ? (uint32_t)(_stats.totalLatencyUs / _stats.acked) : 0;
+    }
+
+   private:
+    struct Entry {
+        char text[LINE_SIZE];
+        uint8_t length;  // with the '\n'
+        uint32_t sentAt;
+    };
+
+    Link _link;
+    LineHandler _handler;
+    void *_handlerContext;
+
+    // Ring of lines: the first _sentCount from _head are in flight
+    Entry _entries[Depth];
+    uint8_t _head;
+    uint8_t _count;
+    uint8_t _sentCount;
+    uint8_t _inFlightBytes;
+
+    char _reply[REPLY_SIZE];
+    uint8_t _replyLength;
+    bool _bannerSeen;
+
+    int _lastError;
+    int _lastAlarm;
+    char _lastErrorLine[LINE_SIZE];
+    Stats _stats;
+
+    // Every queued line that fits in the RX buffer, in one link write.
+    void pump(uint32_t nowUs) {
+        char chunk[RX_BUFFER_SIZE];
+        uint8_t length = 0;
+        while (_sentCount < _count) {
+            Entry &entry = _entries[(_head + _sentCount) % Depth];
+            if (_inFlightBytes + entry.length > RX_BUFFER_SIZE) break;
+            memcpy(&chunk[length], entry.text, entry.length);
+            length += entry.length;
+            entry.sentAt = nowUs;
+            _inFlightBytes += entry.length;
+            _sentCount++;
+            _stats.sent++;
+        }
+        if (length > 0) _link.write(chunk, length);
+        if (_inFlightBytes > _stats.maxInFlight) _stats.maxInFlight = _inFlightBytes;
+    }
+
+    void receive(char c, uint32_t nowUs) {
+        if (c == '\n') {
+            _reply[_replyLength] = '\0';
+            if (_replyLength > 0) parse(nowUs);
+            _replyLength = 0;
+        } else if (c >= 32 && c < 127 && _replyLength < REPLY_SIZE - 1) {
+            _reply[_replyLength++] = c;
+        }
+    }
+
+    void parse(uint32_t nowUs) {
+        if (strcmp(_reply, "ok") == 0) {
+            acknowledge(nowUs, false);
+        } else if (strncmp(_reply, "error:", 6) == 0) {
+            _lastError = atoi(&_reply[6]);
+            _stats.errors++;
+            acknowledge(nowUs, true);
+        } else if (strncmp(_reply, "ALARM:", 6) == 0) {
+            _lastAlarm = atoi(&_reply[6]);
+            _stats.alarms++;
+        } else if (strncmp(_reply, "Grbl ", 5) == 0) {
+            _bannerSeen = true;
+        } else if (_handler != NULL) {
+            _handler(_reply, _handlerContext);
+        }
+    }
+
+    void acknowledge(uint32_t nowUs, bool error) {
+        if (_sentCount == 0) return;  // reply to a line sent before reset()
+        Entry &entry = _entries[_head];
+        if (error) {
+            memcpy(_lastErrorLine, entry.text, entry.length - 1);
+            _lastErrorLine[entry.length - 1] = '\0';
+        }
+        uint32_t latency = nowUs - entry.sentAt;
+        _stats.lastLatencyUs = latency;
+        if (latency > _stats.maxLatencyUs) _stats.maxLatencyUs = latency;
+        _stats.totalLatencyUs += latency;
+        _stats.acked++;
+        _inFlightBytes -= entry.length;
+        _head = (_head + 1) % Depth;
+        _count--;
+        _sentCount--;
+    }
+};
+
+#endif
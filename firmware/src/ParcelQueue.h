@@ -0,0 +1,114 @@
+/**
+ * ParcelQueue.h - Routed parcels between the reader and the diverter
+ *
+ * Fixed-capacity FIFO ring (no allocation) of parcels already routed, each
+ * stamped with the belt position when its tag was read. Parcels cannot
+ * overtake each other on the belt, so the oldest entry is always the next
+ * one at the diverter: service() compares its travel (belt position minus
+ * readMm) with the diverter offsets, and tells the caller when to set the
+ * servo for it and when it has gone through. The servo serves one parcel
+ * at a time, so the next one is switched only once the previous is out.
+ * No Arduino dependency, the caller provides belt position and clock.
+ */
+#ifndef ParcelQueue_h
+#define ParcelQueue_h
+
+#include <stdint.h>
+#include "TagUid.h"
+
+struct Parcel {
+    TagUid uid;
+    uint8_t warehouse;  // 1=A, 2=B, 3=C
+    char store;
+    float readMm;       // belt position when the tag was read
+    uint32_t readAtMs;
+    bool switched;      // diverter already set for this parcel
+
+    Parcel() : warehouse(0), store(0), readMm(0), readAtMs(0), switched(false) {}
+};
+
+// One diverter action from ParcelQueue::service(); call it again until NONE.
+struct DiverterStep {
+    enum Action { NONE, SWITCH, EXIT };
+
+    Action action;
+    Parcel parcel;  // SWITCH: set the servo for it; EXIT: gone, already popped
+    bool late;      // SWITCH: servo may not settle in time; EXIT: never switched
+
+    DiverterStep() : action(NONE), late(false) {}
+    DiverterStep(Action action, const Parcel &parcel, bool late)
+        : action(action), parcel(parcel), late(late) {}
+};
+
+template <uint8_t Capacity>
+class ParcelQueue {
+   public:
+    // Travel from the reader: switchMm = servo commanded, exitMm = parcel out
+    // of the diverter. settleMm: belt travel while the servo moves, a switch
+    // past switchMm + settleMm is late.
+    ParcelQueue(float switchMm, float exitMm, float settleMm)
+        : _switchMm(switchMm), _exitMm(exitMm), _settleMm(settleMm),
+          _head(0), _count(0), _maxCount(0) {}
+
+    void clear() { _head = _count = 0; }
+
+    // false if the queue is full (parcel not added).
+    bool push(const Parcel &parcel) {
+        if (_count == Capacity) return false;
+        _parcels[(_head + _count) % Capacity] = parcel;
+        _count++;
+        if (_count > _maxCount) _maxCount = _count;
+        return true;
+    }
+
+    // Oldest parcel, i.e. the next at the diverter. Queue must not be empty.
+    Parcel &front() { return _parcels[_head]; }
+    const Parcel &front() const { return _parcels[_head]; }
+    // index 0 = oldest.
+    const Parcel &at(uint8_t index) const { return _parcels[(_head + index) % Capacity]; }
+
+    void pop() {
+        if (_count == 0) return;
+        _head = (_head + 1) % Capacity;
+        _count--;
+    }
+
+    DiverterStep service(float positionMm) {
+        if (_count == 0) return DiverterStep();
+        Parcel &parcel = front();
+        float travel = positionMm - parcel.readMm;
+        if (travel >= _exitMm) {
+            DiverterStep step(DiverterStep::EXIT, parcel, !parcel.switched);
+            pop();
+            return step;
+        }
+        if (!parcel.switched && travel >= _switchMm) {
+            parcel.switched = true;
+            return DiverterStep(DiverterStep::SWITCH, parcel, travel > _switchMm + _settleMm);
+        }
+        return DiverterStep();
+    }
+
+    // true if a parcel read at readMm follows the last one too closely: it
+    // would get the servo after its settle point, once the last one is out.
+    bool wouldBeLate(float readMm) const {
+        if (_count == 0) return false;
+        return readMm - at(_count - 1).readMm < _exitMm - _switchMm - _settleMm;
+    }
+
+    uint8_t size() const { return _count; }
+    bool empty() const { return _count == 0; }
+    bool full() const { return _count == Capacity; }
+    uint8_t maxSize() const { return _maxCount; }  // most parcels in flight at once
+
+   private:
+    float _switchMm;
+    float _exitMm;
+    float _settleMm;
+    Parcel _parcels[Capacity];
+    uint8_t _head;
+    uint8_t _count;
+    uint8_t _maxCount;
+};
+
+#endif
@@ -0,0 +1,94 @@
+/**
+ * RouteRecord.h - Routing decision stored on the parcel tag
+ *
+ * 16 bytes, i.e. one MIFARE Classic block or four Ultralight / NTAG pages:
+ *   0-1    magic 'R' 'T'
+ *   2      format version
+ *   3      store letter ('A'..'C', 0 = unknown)
+ *   4      warehouse id (1..3)
+ *   5      id of the station that wrote it
+ *   6      number of writes (routing passes) so far
+ *   7      reserved, 0
+ *   8-11   timestamp, Unix seconds, little endian (0 = clock not set)
+ *   12-13  reserved, 0
+ *   14-15  CRC_A over bytes 0-13 then the tag UID
+ * The UID in the CRC ties the record to its tag: a block copied onto another
+ * tag does not decode. On Ultralight / NTAG it takes the last four user
+ * pages (ultralightPage), which the NDEF message must leave free.
+ * No Arduino dependency.
+ */
+#ifndef RouteRecord_h
+#define RouteRecord_h
+
+#include <stdint.h>
+#include <string.h>
+#include "MFRC522_CRC.h"
+#include "TagUid.h"
+
+struct RouteRecord {
+    static const uint8_t SIZE = 16;
+    static const uint8_t VERSION = 1;
+
+    char store;
+    uint8_t warehouse;
+    uint8_t station;
+    uint8_t writes;
+    uint32_t timestamp;
+
+    RouteRecord() : store(0), warehouse(0), station(0), writes(0), timestamp(0) {}
+
+    bool valid() const { return warehouse != 0; }
+    void clear() { *this = RouteRecord(); }
+
+    void encode(uint8_t *out, const TagUid &uid) const {
+        memset(out, 0, SIZE);
+        out[0] = 'R';
+        out[1] = 'T';
+        out[2] = VERSION;
+        out[3] = store;
+        out[4] = warehouse;
+        out[5] = station;
+        out[6] = writes;
+        for (uint8_t i = 0; i < 4; i++) out[8 + i] = (timestamp >> (8 * i)) & 0xFF;
+        uint16_t crc = checksum(out, uid);
+        out[14] = crc & 0xFF;
+        out[15] = crc >> 8;
+    }
+
+    // false (and cleared) for a blank block, another format, a record
+    // written for another tag or a corrupted one.
+    bool decode(const uint8_t *in, const TagUid &uid) {
+        clear();
+        if (in[0] != 'R' || in[1] != 'T' || in[2] != VERSION || in[4] == 0) return false;
+        uint16_t crc = checksum(in, uid);
+        if (in[14] != (crc & 0xFF) || in[15] != (crc >> 8)) return false;
+        store = in[3];
+        warehouse = in[4];
+        station = in[5];
+        writes = in[6];
+        for (uint8_t i = 0; i < 4; i++) timestamp |= (uint32_t)in[8 + i] << (8 * i);
+        return true;
+    }
+
+    // First of the four record pages of an Ultralight / NTAG tag, from the
+    // data area size in its capability container (page 3, byte 2, in units
+    // of 8 bytes). 0 = unknown layout, no record.
+    static uint8_t ultralightPage(uint8_t ccDataSize) {
+        switch (ccDataSize) {
+            case 0x06: return 12;   // Ultralight / EV1 MF0UL11, user pages 4-15
+            case 0x10: return 32;   // Ultralight EV1 MF0UL21, 4-35
+            case 0x12: return 36;   // NTAG213 / Ultralight C, 4-39
+            case 0x3E: return 126;  // NTAG215, 4-129
+            case 0x6D: return 222;  // NTAG216, 4-225 (after the CC data area)
+            default: return 0;
+        }
+    }
+
+   private:
+    static uint16_t checksum(const uint8_t *data, const TagUid &uid) {
+        uint16_t crc = MFRC522_CRC::compute(data, SIZE - 2);
+        return MFRC522_CRC::update(crc, uid.bytes, uid.size);
+    }
+};
+
+#endif
@@ -0,0 +1,65 @@
+/**
+ * TagUid.h - Packed tag UID value type
+ *
+ * Length + up to 10 bytes (ISO 14443-3 triple size UID), copied by value,
+ * comparable and hashable. Hex encoding goes through a lookup table into a
+ * buffer supplied by the caller, so the read -> API -> display path never
+ * touches the heap. No Arduino dependency.
+ */
+#ifndef TagUid_h
+#define TagUid_h
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+struct TagUid {
+    static const uint8_t MAX_SIZE = 10;
+    // "04:82:3A:11:..." : 3 chars per byte (last separator becomes the NUL)
+    static const size_t HEX_BUFFER_SIZE = MAX_SIZE * 3;
+
+    uint8_t size;
+    uint8_t bytes[MAX_SIZE];
+
+    TagUid() : size(0) { memset(bytes, 0, sizeof(bytes)); }
+
+    TagUid(const uint8_t *data, uint8_t length) : size(length > MAX_SIZE ? MAX_SIZE : length) {
+        memset(bytes, 0, sizeof(bytes));
+        memcpy(bytes, data, size);
+    }
+
+    bool empty() const { return size == 0; }
+    void clear() { *this = TagUid(); }
+
+    bool operator==(const TagUid &other) const {
+        return size == other.size && memcmp(bytes, other.bytes, size) == 0;
+    }
+    bool operator!=(const TagUid &other) const { return !(*this == other); }
+
+    // FNV-1a over the UID bytes
+    uint32_t hash() const {
+        uint32_t h = 2166136261u;
+        for (uint8_t i = 0; i < size; i++) {
+            h = (h ^ bytes[i]) * 16777619u;
+        }
+        return h;
+    }
+
+    // Upper-case hex, `separator` between bytes ('\0' = none). Returns the
+    // length written (without the NUL), 0 if the buffer is too small.
+    size_t toHex(char *out, size_t outSize, char separator = '\0') const {
+        static const char DIGITS[] = "0123456789ABCDEF";
+        size_t needed = size * (separator ? 3 : 2) - (separator && size ? 1 : 0);
+        if (outSize < needed + 1) return 0;
+        char *p = out;
+        for (uint8_t i = 0; i < size; i++) {
+            if (separator && i > 0) *p++ = separator;
+            *p++ = DIGITS[bytes[i] >> 4];
+            *p++ = DIGITS[bytes[i] & 0x0F];
+        }
+        *p = '\0';
+        return needed;
+    }
+};
+
+#endif
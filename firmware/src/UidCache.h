@@ -0,0 +1,77 @@
+/**
+ * UidCache.h - Fixed-capacity cache of recently seen tag UIDs
+ *
+ * Open-addressed table (linear probing, TagUid::hash) keyed by the UID,
+ * with a time-to-live per entry. No allocation: the table is a member array
+ * sized by the template parameter. An entry older than the TTL counts
+ * as free; when every slot is live, the oldest one in the probe is replaced.
+ * No Arduino dependency, the caller provides the clock.
+ */
+#ifndef UidCache_h
+#define UidCache_h
+
+#include <stdint.h>
+#include "TagUid.h"
+
+template <uint8_t Capacity>
+class UidCache {
+   public:
+    explicit UidCache(uint32_t ttlMs) : _ttlMs(ttlMs), _hits(0), _misses(0) { clear(); }
+
+    void clear() {
+        for (uint8_t i = 0; i < Capacity; i++) {
+            _slots[i].used = false;
+            _slots[i].seenAt = 0;
+        }
+    }
+    void setTtl(uint32_t ttlMs) { _ttlMs = ttlMs; }
+
+    // true if the UID was seen less than ttl ago (hit, timestamp refreshed);
+    // otherwise records it and returns false (miss).
+    bool checkAndInsert(const TagUid &uid, uint32_t nowMs) {
+        uint8_t start = uid.hash() % Capacity;
+        int16_t freeSlot = -1;
+        uint8_t oldest = start;
+
+        for (uint8_t i = 0; i < Capacity; i++) {
+            uint8_t index = (start + i) % Capacity;
+            Slot &slot = _slots[index];
+            if (!slot.used) {
+                if (freeSlot < 0) freeSlot = index;
+                break;
+            }
+            bool live = nowMs - slot.seenAt < _ttlMs;
+            if (live && slot.uid == uid) {
+                slot.seenAt = nowMs;
+                _hits++;
+                return true;
+            }
+            if (!live && freeSlot < 0) freeSlot = index;
+            if (nowMs - slot.seenAt > nowMs - _slots[oldest].seenAt) oldest = index;
+        }
+
+        Slot &slot = _slots[freeSlot >= 0 ? freeSlot : oldest];
+        slot.used = true;
+        slot.uid = uid;
+        slot.seenAt = nowMs;
+        _misses++;
+        return false;
+    }
+
+    uint32_t hits() const { return _hits; }
+    uint32_t misses() const { return _misses; }
+
+   private:
+    struct Slot {
+        bool used;
+        TagUid uid;
+        uint32_t seenAt;
+    };
+
+    Slot _slots[Capacity];
+    uint32_t _ttlMs;
+    uint32_t _hits;
+    uint32_t _misses;
+};
+
+#endif
@@ -23,7 +23,15 @@
 #include <WiFi.h>
 #include <HTTPClient.h>
 #include <ArduinoJson.h>
+#include <Preferences.h>
+#include <time.h>
 #include "MFRC522_I2C.h"
+#include "TagUid.h"
+#include "UidCache.h"
+#include "RouteRecord.h"
+#include "GrblStream.h"
+#include "GrblStatus.h"
+#include "ParcelQueue.h"
 
 // ============================================================================
 // CONFIGURATION
@@ -42,6 +50,12 @@ const int   ROUTING_API_PORT = 3000;
 #define GOPLUS2_ADDR    0x38
 #define GRBL_I2C_ADDR   0x70
 
+// Broche IRQ du MFRC522 (-1 = non cablee : attente par polling temporise)
+#define RFID_IRQ_PIN    -1
+
+// Debug : verifie le cache des registres MFRC522 contre la puce a chaque lecture
+#define RFID_SHADOW_VERIFY  false
+
 // Servo (sur GoPlus2)
 #define SERVO_CH1       0
 
@@ -54,16 +68,60 @@ const int   ROUTING_API_PORT = 3000;
 // Timeouts (ms)
 #define WIFI_TIMEOUT        20000
 #define RFID_SCAN_TIMEOUT   5000
+#define RFID_RETRIES        2       // Relances WUPA immediates par lecture
+#define RFID_FIELD_RESET_MS 2       // Coupure du champ avant relance (0 = aucune)
+#define RFID_IDLE_TIMEOUT   30000   // Sans tag depuis 30 s -> mode basse consommation (0 = jamais)
+#define RFID_IDLE_PROBE_MS  200     // Periode des sondes champ en mode basse consommation
+#define RFID_IDLE_SETTLE_MS 5       // Mise sous tension des tags avant la sonde (ISO : 5 ms)
+#define RFID_CAL_ATTEMPTS   10      // Selections par reglage pendant la calibration
+#define RFID_CAL_AT_BOOT    true    // Calibrer au demarrage si un tag de reference est present
+#define RFID_PAYLOAD_SECTOR  1      // 1er secteur de la charge utile colis (MIFARE Classic)
+#define RFID_PAYLOAD_SECTORS 0      // Secteurs lus par colis, 3 blocs de 16 octets (0 = pas de lecture)
+#define RFID_RECORD_WRITE    true   // Ecrire la decision d'aiguillage sur le tag
+#define RFID_RECORD_SECTOR   3      // MIFARE Classic : bloc 0 de ce secteur, hors charge utile
+// Ultralight/NTAG : 4 dernieres pages utilisateur selon le type (RouteRecord::ultralightPage),
+// reservees : le message NDEF doit laisser libres les 16 derniers octets
+#define RFID_RECORD_BUDGET_MS 50    // Ecriture tag attendue sous ce delai (fenetre lecteur)
+#define RFID_FIELD_MM        30     // Longueur de la zone de lecture le long du tapis (a mesurer)
+#define STATION_ID           1      // Identifiant de ce convoyeur dans les enregistrements tag
+#define RFID_RECORD_ROUTING  true   // Router depuis l'enregistrement tag (API = repli)
+#define UID_CACHE_TTL_MS    30000   // Un meme UID relu dans ce delai est ignore (doublon)
+#define UID_CACHE_SIZE      16
 #define API_TIMEOUT         5000
+#define GRBL_ACK_TIMEOUT    1000    // Acquittement (ok/error) de toutes les lignes envoyees
+#define GRBL_RESET_TIMEOUT  1000    // Banniere "Grbl" apres soft reset
+#define GRBL_I2C_CHUNK      32      // Tampon I2C esclave du module GRBL (ATmega)
+#define GRBL_STOP_BUDGET_MS 50      // Arret tapis (feed hold -> immobile) attendu sous ce delai
+#define GRBL_STATUS_PERIOD_MS 100   // Rapports d'etat '?' (etat, position tapis, avance)
+#define GRBL_STATUS_STALE_MS  500   // Sans rapport depuis : position tapis estimee (vitesse)
 #define MOTOR_MOVE_TIME     2000
 
 // Vitesses moteur (mm/min)
 #define CONVEYOR_SLOW_SPEED   20    // Vitesse lente continue (tapis en marche)
 #define CONVEYOR_EJECT_SPEED  3000  // Vitesse d'ejection du colis
 
+// Vitesse tapis en marche : override d'avance GRBL (% de CONVEYOR_SLOW_SPEED, 10-200)
+#define BELT_CRUISE_OVERRIDE  200   // Entre colis (lecteur vide)
+#define BELT_READ_OVERRIDE    30    // Tag dans le champ : lecture, API, ecriture tag
+
 // Servo timing (ms)
 #define SERVO_MOVE_DELAY      500   // Temps pour que le servo atteigne sa position
-#define SERVO_HOLD_TIME       10000  // Temps de maintien du servo pendant le passage du colis
+
+// Colis en vol : aiguillage planifie sur la position tapis de chaque colis
+#define PARCEL_QUEUE_SIZE     8     // Colis entre lecteur et aiguillage
+#define DIVERTER_OFFSET_MM    60    // Lecture -> servo commande (SERVO_MOVE_DELAY avant l'entree)
+#define READER_TO_DIVERTER_MM 120   // Lecture -> colis sorti de l'aiguillage (a mesurer)
+#define DIVERTER_SETTLE_MM    (SERVO_MOVE_DELAY * BELT_SPEED_MM_PER_S * BELT_CRUISE_OVERRIDE / 100000.0f)  // Course en croisiere pendant SERVO_MOVE_DELAY
+#define BELT_SPEED_MM_PER_S   25    // Vitesse reelle du tapis a CONVEYOR_SLOW_SPEED (a mesurer)
+#define BELT_MM_PER_Z_MM      (BELT_SPEED_MM_PER_S * 60.0f / CONVEYOR_SLOW_SPEED)  // Tapis / axe Z GRBL
+
+#if RFID_RECORD_SECTOR >= RFID_PAYLOAD_SECTOR && RFID_RECORD_SECTOR < RFID_PAYLOAD_SECTOR + RFID_PAYLOAD_SECTORS
+#error "RFID_RECORD_SECTOR ecraserait la charge utile colis"
+#endif
+// Pire cas : tag detecte tapis en croisiere, l'ecriture doit tenir dans la traversee du champ
+#if RFID_RECORD_BUDGET_MS * BELT_SPEED_MM_PER_S * BELT_CRUISE_OVERRIDE >= RFID_FIELD_MM * 100000
+#error "RFID_RECORD_BUDGET_MS plus long que la traversee du champ en croisiere"
+#endif
 
 // ============================================================================
 // ETATS DE LA MACHINE
@@ -90,16 +148,32 @@ const char* stateNames[] = {
 ConveyorState currentState = STATE_INIT;
 String lastError = "";
 
-String currentUID = "";      // UID lu (format "04:82:..." selon MFRC522)
+TagUid currentUID;           // UID lu (vide = aucun colis en cours)
+#if RFID_PAYLOAD_SECTORS > 0
+byte tagPayload[RFID_PAYLOAD_SECTORS * 48];  // Blocs de donnees du tag (MIFARE Classic)
+uint16_t tagPayloadLen = 0;  // 0 = pas de charge utile lue
+#endif
+RouteRecord tagRecord;       // Decision lue sur le tag (station precedente)
+byte tagRecordPage = 0;      // 1re page de l'enregistrement (Ultralight/NTAG, 0 = inconnue)
 String currentStore = "";    // "A" / "B" / "C"
 int targetWarehouse = 2;     // 1=A, 2=B, 3=C (B par defaut)
+bool routeConfirmed = false; // Decision tag ou API (pas le mode degrade) -> ecrite sur le tag
+uint32_t parcelsRouted = 0;  // Colis aiguilles depuis le demarrage
+uint32_t parcelsOffline = 0; // ... dont routes depuis le tag, sans reseau
 
-MFRC522 rfid(RFID_I2C_ADDR);
+MFRC522 rfid(RFID_I2C_ADDR, RFID_IRQ_PIN);
+UidCache<UID_CACHE_SIZE> uidCache(UID_CACHE_TTL_MS);
 bool rfidOK = false;
 bool grblOK = false;
 bool servoOK = false;
 bool wifiOK = false;
 bool conveyorRunning = false;
+unsigned long tagDetectedAt = 0;    // micros() de la 1re reponse du tag
+
+// Colis routes, de la lecture a la sortie de l'aiguillage
+ParcelQueue<PARCEL_QUEUE_SIZE> parcels(DIVERTER_OFFSET_MM, READER_TO_DIVERTER_MM, DIVERTER_SETTLE_MM);
+float tagReadMm = 0;                // Position tapis a la lecture du tag en cours
+uint32_t parcelsDiverted = 0;
 
 // ============================================================================
 // FONCTIONS AFFICHAGE
@@ -162,11 +236,13 @@ void displayState() {
     M5.Lcd.setTextColor(servoOK ? GREEN : RED);
     M5.Lcd.println(servoOK ? "OK" : "KO");
 
-    if (currentUID.length() > 0) {
+    if (!currentUID.empty()) {
+        char hex[TagUid::HEX_BUFFER_SIZE];
+        currentUID.toHex(hex, sizeof(hex), ':');
         M5.Lcd.setCursor(10, 160);
         M5.Lcd.setTextColor(YELLOW);
         M5.Lcd.print("UID: ");
-        M5.Lcd.println(currentUID);
+        M5.Lcd.println(hex);
     }
 
     if (currentStore.length() > 0) {
@@ -204,114 +280,426 @@ bool initServo() {
 // FONCTIONS GRBL (Moteur convoyeur)
 // ============================================================================
 
-void sendGcode(const char* cmd) {
+// Liaison I2C du module GRBL pour GrblStream (lignes decoupees au tampon
+// esclave, lecture des reponses par blocs de 32 octets)
+struct GrblI2CLink {
+    void write(const char* data, uint8_t length) {
+        while (length > 0) {
+            uint8_t n = length < GRBL_I2C_CHUNK ? length : GRBL_I2C_CHUNK;
+            Wire.beginTransmission(GRBL_I2C_ADDR);
+            Wire.write((const uint8_t*)data, n);
+            Wire.endTransmission();
+            data += n;
+            length -= n;
+        }
+    }
+    uint8_t read(char* buffer, uint8_t size) {
+        uint8_t n = 0;
+        Wire.requestFrom(GRBL_I2C_ADDR, size);
+        while (Wire.available() && n < size) buffer[n++] = Wire.read();
+        return n;
+    }
+};
+
+typedef GrblStream<GrblI2CLink> GrblSender;
+GrblSender grbl((GrblI2CLink()));
+unsigned long lastStopMs = 0;  // Latence du dernier arret tapis
+unsigned long maxStopMs = 0;
+uint32_t stopCount = 0;
+GrblStatus grblStatus;         // Dernier rapport '?' (etat, MPos, FS, Bf, Ov)
+unsigned long lastStatusRequest = 0;
+bool statusAwaited = false;    // '?' envoye, rapport pas encore lu
+unsigned long lastStatusAt = 0;  // millis() du dernier rapport lu
+uint8_t beltOverride = 100;    // Override d'avance GRBL en cours (%)
+bool beltHeld = false;         // Tapis en feed hold : reprise par '~'
+unsigned long beltStartedAt = 0;  // millis() du dernier demarrage / reprise
+
+// Reponses GRBL hors ok/error/ALARM ([MSG:...], etat...)
+void onGrblLine(const char* line, void*) {
+    if (grblStatus.parse(line)) {  // Rapport d'etat
+        statusAwaited = false;
+        lastStatusAt = millis();
+        return;
+    }
+    Serial.print("GRBL RX: ");
+    Serial.println(line);
+}
+
+// Position du tapis (mm) d'apres la position machine Z
+float beltPositionMm() {
+    return grblStatus.mpos[2] * BELT_MM_PER_Z_MM;
+}
+
+// Vitesse reellement commandee (override compris)
+float beltSpeedMmPerS() {
+    return BELT_SPEED_MM_PER_S * beltOverride / 100.0f;
+}
+
+// Vitesse mesuree : avance reelle (FS) du dernier rapport GRBL, acceleration
+// et override compris
+float beltMeasuredSpeedMmPerS() {
+    return grblStatus.feed * BELT_MM_PER_Z_MM / 60.0f;
+}
+
+// Lit les reponses GRBL, envoie la suite de la file, signale erreurs et alarmes
+void grblPoll() {
+    static uint32_t errors = 0;
+    static uint32_t alarms = 0;
+    grbl.poll(micros());
+    const GrblSender::Stats& stats = grbl.stats();
+    if (stats.errors != errors) {
+        errors = stats.errors;
+        Serial.printf("GRBL RX: error:%d (%s)\n", grbl.lastError(), grbl.lastErrorLine());
+    }
+    if (stats.alarms != alarms) {
+        alarms = stats.alarms;
+        Serial.printf("GRBL RX: ALARM:%d\n", grbl.lastAlarm());
+    }
+}
+
+// Met la ligne en file et rend la main : elle part des qu'elle tient dans le
+// tampon RX de GRBL (comptage des caracteres), sans attendre son "ok"
+bool sendGcode(const char* cmd) {
     Serial.print("GRBL TX: ");
     Serial.println(cmd);
 
-    Wire.beginTransmission(GRBL_I2C_ADDR);
-    for (size_t i = 0; i < strlen(cmd); i++) Wire.write(cmd[i]);
-    Wire.write('\r');
-    Wire.write('\n');
-    Wire.endTransmission();
+    unsigned long start = millis();
+    while (!grbl.send(cmd, micros())) {
+        if (millis() - start > GRBL_ACK_TIMEOUT) {
+            Serial.println("GRBL: file d'envoi bloquee");
+            return false;
+        }
+        grblPoll();
+        yield();
+    }
+    return true;
+}
 
-    delay(100);
+// Attend l'acquittement de toutes les lignes envoyees
+bool grblSync(unsigned long timeoutMs) {
+    unsigned long start = millis();
+    while (!grbl.idle()) {
+        if (millis() - start > timeoutMs) {
+            Serial.printf("GRBL: %u lignes sans acquittement\n", (unsigned)grbl.depth());
+            return false;
+        }
+        grblPoll();
+        yield();
+    }
+    return true;
+}
+
+// Latence commande -> ok et remplissage du tampon GRBL
+void printGrblStats() {
+    const GrblSender::Stats& stats = grbl.stats();
+    Serial.printf("GRBL: %u lignes, %u erreurs, %u alarmes\n",
+                  (unsigned)stats.sent, (unsigned)stats.errors, (unsigned)stats.alarms);
+    Serial.printf("GRBL: latence ok moy %lu us, max %lu us, derniere %lu us\n",
+                  (unsigned long)grbl.averageLatencyUs(), (unsigned long)stats.maxLatencyUs,
+                  (unsigned long)stats.lastLatencyUs);
+    Serial.printf("GRBL: file max %u lignes, tampon RX max %u/%u octets\n",
+                  stats.maxDepth, stats.maxInFlight, GrblSender::RX_BUFFER_SIZE);
+    Serial.printf("GRBL: %u arrets tapis, dernier %lu ms, max %lu ms\n",
+                  (unsigned)stopCount, lastStopMs, maxStopMs);
+    Serial.printf("GRBL: override tapis %u%% (GRBL %u%%), %.1f mm/s commandes, %.1f mm/s mesures\n",
+                  beltOverride, grblStatus.feedOverride, beltSpeedMmPerS(), beltMeasuredSpeedMmPerS());
+    Serial.printf("GRBL: %s, Z %.3f mm (tapis %.1f mm), avance %.1f mm/min, tampon %d blocs / %d octets libres\n",
+                  GrblStatus::stateName(grblStatus.state), grblStatus.mpos[2], beltPositionMm(),
+                  grblStatus.feed, grblStatus.plannerFree, grblStatus.rxFree);
+}
+
+// Sondage non bloquant (loop) : un '?' toutes les GRBL_STATUS_PERIOD_MS, le
+// rapport est lu par les grblPoll suivants. Lecture I2C seulement si une
+// reponse est attendue
+void grblStatusPoll() {
+    unsigned long now = millis();
+    if (now - lastStatusRequest >= GRBL_STATUS_PERIOD_MS) {
+        lastStatusRequest = now;
+        grbl.realtime('?');
+        statusAwaited = true;
+    }
+    if (statusAwaited || !grbl.idle()) grblPoll();
+}
 
-    Wire.requestFrom(GRBL_I2C_ADDR, (uint8_t)32);
-    String response = "";
-    while (Wire.available()) {
-        char c = Wire.read();
-        if (c >= 32 && c < 127) response += c;
+// Rapport demande maintenant (position de depart d'un mouvement...)
+bool grblRefreshStatus(unsigned long timeoutMs) {
+    uint32_t reports = grblStatus.reports;
+    unsigned long start = millis();
+    grbl.realtime('?');
+    lastStatusRequest = start;
+    while (grblStatus.reports == reports) {
+        if (millis() - start > timeoutMs) return false;
+        grblPoll();
+        yield();
+    }
+    return true;
+}
+
+// Attend un rapport Idle ou Hold:0, demande apres l'appel : un '?' des que
+// le precedent a repondu, timeoutMs au total
+bool grblWaitStopped(unsigned long timeoutMs) {
+    unsigned long start = millis();
+    unsigned long elapsed;
+    while ((elapsed = millis() - start) < timeoutMs) {
+        if (grblRefreshStatus(timeoutMs - elapsed) && grblStatus.stopped()) return true;
     }
-    if (response.length() > 0) {
-        Serial.print("GRBL RX: ");
-        Serial.println(response);
+    return false;
+}
+
+// Reglage $ (EEPROM) : envoye seul et acquitte avant la ligne suivante.
+// GRBL ecrit l'EEPROM interruptions coupees et perdrait les caracteres
+// recus pendant ce temps
+bool grblSetting(const char* setting) {
+    uint32_t errors = grbl.stats().errors;
+    if (!grblSync(GRBL_ACK_TIMEOUT) || !sendGcode(setting) || !grblSync(GRBL_ACK_TIMEOUT)) {
+        return false;
     }
+    return grbl.stats().errors == errors;
 }
 
 bool initGRBL() {
     Wire.beginTransmission(GRBL_I2C_ADDR);
     if (Wire.endTransmission() == 0) {
-        delay(500);
+        unsigned long start = millis();
+        grbl.reset();
+        grbl.setLineHandler(onGrblLine);
         sendGcode("$X");           // Unlock
-        delay(200);
-        sendGcode("$102=80");      // Z steps/mm
-        delay(100);
-        sendGcode("$112=500");     // Z max rate mm/min
-        delay(100);
-        sendGcode("$122=50");      // Z acceleration mm/sec^2 (evite les vibrations)
-        delay(100);
+        // Reglages EEPROM une seule fois ici (conserves par les soft resets)
+        bool ok = grblSetting("$102=80")    // Z steps/mm
+               && grblSetting("$112=500")   // Z max rate mm/min
+               && grblSetting("$122=50")    // Z acceleration mm/sec^2 (evite les vibrations)
+               && grblSetting("$10=3");     // Rapports d'etat : MPos + tampons (Bf)
         sendGcode("G21");          // Millimeters
-        delay(100);
         sendGcode("G90");          // Absolute
-        delay(100);
         sendGcode("G92 Z0");       // Set zero
-        Serial.println("GRBL Module OK @ 0x70");
+        if (!grblSync(GRBL_ACK_TIMEOUT)) {
+            Serial.println("GRBL Module sans reponse");
+            return false;
+        }
+        if (!ok) Serial.println("GRBL: reglages $ refuses ou sans reponse");
+        Serial.printf("GRBL Module OK @ 0x70 (%lu ms)\n", millis() - start);
         return true;
     }
     Serial.println("GRBL Module NOT FOUND!");
     return false;
 }
 
-// Commande temps-reel GRBL (sans \r\n)
+// Commande temps-reel GRBL (sans \r\n, hors tampon RX)
 void sendRealtimeCmd(char cmd) {
-    Wire.beginTransmission(GRBL_I2C_ADDR);
-    Wire.write(cmd);
-    Wire.endTransmission();
-    delay(150);
+    grbl.realtime(cmd);
 }
 
-// Demarrer le tapis en mode continu lent (non bloquant)
-// Appeler uniquement quand GRBL est en etat IDLE (apres conveyorStop ou init)
-void conveyorStartSlow() {
-    char cmd[32];
-    sendGcode("G91");
-    sprintf(cmd, "G1 Z5000 F%d", CONVEYOR_SLOW_SPEED);
-    sendGcode(cmd);
-    sendGcode("G90");
+// Marche continue = un G1 (l'override d'avance ne s'applique pas aux jogs),
+// arrete par feed hold et repris par cycle start : ni reset ni deverrouillage.
+// Deplacements manuels = jogs ($J=, G91/G21 propres a la ligne), depuis Idle.
+
+bool grblStatusStale() {
+    return millis() - lastStatusAt > GRBL_STATUS_STALE_MS;
+}
+
+// Position tapis sans attendre de rapport : le dernier lu, prolonge a la
+// vitesse commandee si les rapports manquent (I2C, GRBL occupe) alors que le
+// tapis doit tourner. Tapis arrete (stop, feed hold, jog fini) : figee
+float beltEstimateMm() {
+    float position = beltPositionMm();
+    if (grblStatusStale() && conveyorRunning && !beltHeld) {
+        float speed = grblStatus.state == GrblStatus::RUN ? beltMeasuredSpeedMmPerS() : beltSpeedMmPerS();
+        position += speed * (millis() - lastStatusAt) / 1000.0f;
+    }
+    return position;
+}
+
+// Override d'avance en temps reel (0x90 = 100 %, 0x91/0x92 = +/-10 %,
+// 0x93/0x94 = +/-1 %), par le plus court chemin, en une ecriture I2C.
+// Le tapis change de vitesse sans arret ni vidage de la file
+void beltSetOverride(int percent) {
+    if (percent < 10) percent = 10;
+    if (percent > 200) percent = 200;
+    if (percent == beltOverride) return;
+
+    char cmds[24];
+    uint8_t n = 0;
+    int diff = percent - beltOverride;
+    if (abs(percent - 100) < abs(diff)) {
+        cmds[n++] = (char)0x90;
+        diff = percent - 100;
+    }
+    while (diff >= 10 && n < sizeof(cmds)) { cmds[n++] = (char)0x91; diff -= 10; }
+    while (diff <= -10 && n < sizeof(cmds)) { cmds[n++] = (char)0x92; diff += 10; }
+    while (diff > 0 && n < sizeof(cmds)) { cmds[n++] = (char)0x93; diff--; }
+    while (diff < 0 && n < sizeof(cmds)) { cmds[n++] = (char)0x94; diff++; }
+    grbl.realtime(cmds, n);
+    beltOverride = percent;
+
+    Serial.printf("Tapis: override %d%% -> F%d, %.1f mm/s\n", percent,
+                  CONVEYOR_SLOW_SPEED * percent / 100, beltSpeedMmPerS());
+}
+
+// Demarrer le tapis en mode continu lent
+// Tapis en feed hold : reprise immediate. Sinon nouveau G1, seulement si le
+// dernier rapport dit Idle (G-code refuse pendant un jog : error:9), et
+// tapis en marche seulement si les 3 lignes sont acquittees "ok".
+// false = pas demarre, nouvel essai au prochain passage
+bool conveyorStartSlow() {
+    if (beltHeld) {
+        sendRealtimeCmd('~');  // Cycle start : reprend le G1 en cours
+        beltHeld = false;
+    } else {
+        if (grblStatus.state != GrblStatus::IDLE) return false;
+        uint32_t errors = grbl.stats().errors;
+        char cmd[32];
+        sprintf(cmd, "G1 Z5000 F%d", CONVEYOR_SLOW_SPEED);
+        bool sent = sendGcode("G91") && sendGcode(cmd) && sendGcode("G90");
+        if (!sent || !grblSync(GRBL_ACK_TIMEOUT) || grbl.stats().errors != errors) {
+            Serial.println("Tapis: demarrage refuse par GRBL");
+            return false;
+        }
+    }
     conveyorRunning = true;
-    Serial.println("Tapis: DEMARRAGE LENT");
+    beltStartedAt = millis();
+    Serial.printf("Tapis: DEMARRAGE LENT (%.1f mm/s)\n", beltSpeedMmPerS());
+    return true;
 }
 
-// Arret tapis - soft reset GRBL (vide le buffer et annule tout mouvement)
-void conveyorStop() {
+// G1 de marche continue termine (course Z finie, ~2 h a 200 %) : GRBL
+// repasse en Idle alors que le tapis devrait tourner. Rapport demande
+// apres le demarrage seulement (2 periodes de sondage)
+bool conveyorRunEnded() {
+    return conveyorRunning && !beltHeld && grbl.idle() &&
+           grblStatus.state == GrblStatus::IDLE &&
+           millis() - beltStartedAt > 2 * GRBL_STATUS_PERIOD_MS;
+}
+
+// Secours : soft reset GRBL (vide le buffer, annule tout mouvement, deverrouille)
+void grblSoftReset() {
     sendRealtimeCmd(0x18);  // Ctrl+X : soft reset GRBL
-    delay(800);             // Attendre que GRBL redémarre
-    sendGcode("$X");        // Unlock après reset
-    delay(100);
-    sendGcode("$122=50");   // Reconfirmer acceleration (anti-vibrations)
-    delay(100);
+    grbl.reset();           // Tampon GRBL vide : plus rien en attente d'acquittement
+    beltHeld = false;
+    beltOverride = 100;     // Overrides remis a 100 % par le reset
+    unsigned long start = millis();
+    while (!grbl.bannerSeen() && millis() - start < GRBL_RESET_TIMEOUT) {
+        grblPoll();         // Attendre que GRBL redémarre (banniere)
+        yield();
+    }
+    sendGcode("$X");        // Unlock après reset ($ en EEPROM : inchanges)
     sendGcode("G21");       // Remettre en mode mm
     sendGcode("G90");       // Remettre en mode absolu
+    Serial.printf("GRBL: soft reset, redemarrage %lu ms\n", millis() - start);
+}
+
+// Arret tapis : feed hold (+ jog cancel si un jog tourne), sans ligne G-code
+// (refusee en Jog / Hold). Latence = jusqu'au premier rapport d'etat Hold:0
+// (decelere, immobile) ou Idle (jog annule).
+// Pas de reset : machine toujours deverrouillee, reprise immediate
+void conveyorStop() {
+    unsigned long start = millis();
+    const char stop[] = {'!', (char)0x85};
+    grbl.realtime(stop, sizeof(stop));
+    bool stopped = grblWaitStopped(GRBL_ACK_TIMEOUT);
+    lastStopMs = millis() - start;
+    beltHeld = stopped && grblStatus.state == GrblStatus::HOLD;
+    // Alarm (ou aucun rapport en GRBL_ACK_TIMEOUT) : seul un reset debloque GRBL
+    if (!stopped) {
+        Serial.printf("Tapis: feed hold sans effet (%s) -> soft reset\n",
+                      GrblStatus::stateName(grblStatus.state));
+        grblSoftReset();
+    }
     conveyorRunning = false;
-    Serial.println("Tapis: STOP (Soft Reset)");
+
+    if (lastStopMs > maxStopMs) maxStopMs = lastStopMs;
+    stopCount++;
+    Serial.printf("Tapis: STOP en %lu ms\n", lastStopMs);
+    if (lastStopMs > GRBL_STOP_BUDGET_MS) {
+        Serial.printf("Tapis: arret au-dela de %d ms\n", GRBL_STOP_BUDGET_MS);
+    }
 }
 
-void conveyorForward(int distance_mm) {
-    char cmd[32];
-    sendGcode("G91");
-    sprintf(cmd, "G1 Z%d F%d", distance_mm, CONVEYOR_EJECT_SPEED);
+// Jog depuis un tapis en feed hold : GRBL n'accepte les jogs qu'en Idle,
+// et seul un reset abandonne le G1 suspendu
+void conveyorReleaseHold() {
+    if (beltHeld) grblSoftReset();
+}
+
+// Jog bloquant (distance signee) : fin du mouvement constatee sur les
+// rapports d'etat (arret + position machine), plus sur une duree estimee.
+// Au retour GRBL est en Idle : le G1 de marche continue peut repartir
+void conveyorJog(int distance_mm) {
+    conveyorReleaseHold();
+    if (!grblRefreshStatus(GRBL_ACK_TIMEOUT)) Serial.println("GRBL: pas de rapport d'etat");
+    float target = grblStatus.mpos[2] + distance_mm;
+    char cmd[40];
+    sprintf(cmd, "$J=G91 G21 Z%d F%d", distance_mm, CONVEYOR_EJECT_SPEED);
     sendGcode(cmd);
-    sendGcode("G90");
-    Serial.printf("conveyorForward: %dmm (non-bloquant)\n", distance_mm);
+
+    // Securite seulement : 2x la duree theorique + une seconde
+    unsigned long timeout = abs(distance_mm) * 120000UL / CONVEYOR_EJECT_SPEED + 1000;
+    unsigned long start = millis();
+    while (millis() - start < timeout) {
+        bool planned = grbl.idle();  // Jog acquitte avant la demande de rapport
+        if (grblRefreshStatus(GRBL_ACK_TIMEOUT) && planned && grblStatus.stopped()) break;
+    }
+    Serial.printf("Tapis: jog %+dmm en %lu ms (Z %.3f, ecart %.3f mm)\n", distance_mm,
+                  millis() - start, grblStatus.mpos[2], grblStatus.mpos[2] - target);
+}
+
+void conveyorForward(int distance_mm) {
+    conveyorJog(distance_mm);
 }
 
 void conveyorBackward(int distance_mm) {
-    sendGcode("G91");
-    char cmd[32];
-    sendGcode("G91");
-    sprintf(cmd, "G1 Z-%d F%d", distance_mm, CONVEYOR_EJECT_SPEED);
-    sendGcode(cmd);
-    sendGcode("G90");
-    int moveTime = (int)((float)distance_mm / CONVEYOR_EJECT_SPEED * 60000.0f * 1.2f);
-    if (moveTime < 500) moveTime = 500;
-    Serial.printf("conveyorBackward: %dmm, attente %dms\n", distance_mm, moveTime);
-    delay(moveTime);
+    conveyorJog(-distance_mm);
 }
 
 // ============================================================================
 // FONCTIONS RFID
 // ============================================================================
 
+// Reglage reception sauvegarde en NVS (sinon gain max par defaut)
+void loadRxConfig() {
+    Preferences prefs;
+    MFRC522::RxConfig config;
+    prefs.begin("rfid", true);
+    bool stored = prefs.getBytes("rxcfg", &config, sizeof(config)) == sizeof(config);
+    prefs.end();
+
+    if (stored) {
+        rfid.PCD_SetRxConfig(config);
+        Serial.printf("RFID: reglage NVS gain 0x%02X seuil 0x%02X demod 0x%02X\n",
+                      config.gain, config.rxThreshold, config.demod);
+    } else {
+        rfid.PCD_SetAntennaGain(rfid.RxGain_max);
+    }
+}
+
+// Balayage gain / RxThreshold / DemodReg sur un tag de reference pose sur le
+// lecteur. Le meilleur reglage (reussites puis temps de selection) est
+// applique et sauvegarde. Sans tag : reglage courant conserve.
+bool calibrateRFID() {
+    if (rfid.PICC_DetectAndSelect(&rfid.uid, true, 0, 0) == MFRC522::STATUS_TIMEOUT) {
+        Serial.println("RFID calibration: pas de tag de reference");
+        return false;
+    }
+    rfid.PICC_HaltA();
+
+    displayStatus("Calibration RFID...", BLUE);
+    MFRC522::RxScore best;
+    unsigned long start = millis();
+    if (rfid.PCD_CalibrateRx(RFID_CAL_ATTEMPTS, &best) != MFRC522::STATUS_OK) {
+        Serial.println("RFID calibration: echec");
+        return false;
+    }
+    Serial.printf("RFID calibration (%lu ms): gain 0x%02X seuil 0x%02X demod 0x%02X\n",
+                  millis() - start, best.config.gain, best.config.rxThreshold, best.config.demod);
+    Serial.printf("  %u/%u selections, %lu us en moyenne\n",
+                  best.successes, best.attempts, (unsigned long)best.avgSelectUs);
+
+    Preferences prefs;
+    prefs.begin("rfid", false);
+    prefs.putBytes("rxcfg", &best.config, sizeof(best.config));
+    prefs.end();
+    return true;
+}
+
 bool initRFID() {
     rfid.PCD_Init();
     delay(100);
@@ -321,7 +709,10 @@ bool initRFID() {
     Serial.println(version, HEX);
 
     if (version == 0x91 || version == 0x92 || version == 0x88 || version == 0x15) {
-        rfid.PCD_SetAntennaGain(rfid.RxGain_max);
+        rfid.PCD_SetShadowVerify(RFID_SHADOW_VERIFY);
+        loadRxConfig();
+        if (RFID_CAL_AT_BOOT) calibrateRFID();
+        rfid.PCD_SetLowPowerDetect(RFID_IDLE_TIMEOUT, RFID_IDLE_PROBE_MS, RFID_IDLE_SETTLE_MS);
         Serial.println("RFID Unit 2 OK @ 0x28");
         return true;
     }
@@ -329,23 +720,125 @@ bool initRFID() {
     return false;
 }
 
-// UID au format "04:82:..."
-String readRFIDTag() {
-    if (!rfid.PICC_IsNewCardPresent()) return "";
-    if (!rfid.PICC_ReadCardSerial()) return "";
+// Bilan d'une periode basse consommation. Occupation bus estimee a 100 kHz :
+// ~9 bits par octet + adresse/START/STOP par transaction.
+void logLowPowerWake() {
+    MFRC522::LowPowerStats lp = rfid.PCD_GetLowPowerStats();
+    unsigned long busUs = (lp.idleBus.bytes + lp.idleBus.transactions) * 90UL;
+    float occupancy = lp.idleMs ? busUs / (lp.idleMs * 10.0f) : 0;
+    Serial.printf("RFID reveil #%u: %lu ms en veille, %u sondes, reveil en %lu us\n",
+                  (unsigned)lp.wakeups, (unsigned long)lp.idleMs, (unsigned)lp.probes,
+                  (unsigned long)lp.lastWakeUs);
+    Serial.printf("RFID veille: %u transactions, %u octets, bus occupe %.2f%%\n",
+                  (unsigned)lp.idleBus.transactions, (unsigned)lp.idleBus.bytes, occupancy);
+}
 
-    String uid = "";
-    for (byte i = 0; i < rfid.uid.size; i++) {
-        if (rfid.uid.uidByte[i] < 0x10) uid += "0";
-        uid += String(rfid.uid.uidByte[i], HEX);
-        if (i < rfid.uid.size - 1) uid += ":";
+#if RFID_PAYLOAD_SECTORS > 0
+// Charge utile d'un tag MIFARE Classic selectionne : une authentification par
+// secteur (cle en cache d'un tag a l'autre), blocs lus a la suite
+void readTagPayload() {
+    MFRC522::SectorTiming timings[RFID_PAYLOAD_SECTORS];
+    memset(timings, 0, sizeof(timings));
+    uint16_t size = sizeof(tagPayload);
+    byte result = rfid.MIFARE_ReadSectors(RFID_PAYLOAD_SECTOR, RFID_PAYLOAD_SECTORS,
+                                          tagPayload, &size, timings);
+    tagPayloadLen = (result == MFRC522::STATUS_OK) ? size : 0;
+
+    for (byte i = 0; i < RFID_PAYLOAD_SECTORS && timings[i].status != 0; i++) {
+        Serial.printf("RFID secteur %u: auth %lu us (cle %u), lecture %lu us\n",
+                      timings[i].sector, (unsigned long)timings[i].authUs,
+                      timings[i].keyIndex, (unsigned long)timings[i].readUs);
+    }
+    if (result != MFRC522::STATUS_OK) {
+        Serial.printf("RFID charge utile: echec (%s)\n",
+                      (const char*)rfid.GetStatusCodeName(result));
     }
-    uid.toUpperCase();
+}
+#endif
+
+// Enregistrement d'aiguillage du tag selectionne : bloc 0 du secteur
+// RFID_RECORD_SECTOR (Classic) ou 4 dernieres pages utilisateur, trouvees
+// avec le Capability Container en page 3 (Ultralight/NTAG)
+void readRouteRecord(byte piccType) {
+    tagRecord.clear();
+    tagRecordPage = 0;
+    TagUid uid(rfid.uid.uidByte, rfid.uid.size);
+    byte block[18];
+    byte size = sizeof(block);
+    if (piccType == MFRC522::PICC_TYPE_MIFARE_UL) {
+        if (rfid.MIFARE_Read(3, block, &size) != MFRC522::STATUS_OK) return;
+        tagRecordPage = RouteRecord::ultralightPage(block[2]);
+        if (tagRecordPage == 0) {
+            Serial.printf("RFID: taille NTAG inconnue (CC 0x%02X), pas d'enregistrement\n", block[2]);
+            return;
+        }
+        size = sizeof(block);
+        if (rfid.MIFARE_Read(tagRecordPage, block, &size) != MFRC522::STATUS_OK) return;
+    } else if (piccType == MFRC522::PICC_TYPE_MIFARE_1K || piccType == MFRC522::PICC_TYPE_MIFARE_4K) {
+        if (rfid.MIFARE_AuthenticateSector(RFID_RECORD_SECTOR) != MFRC522::STATUS_OK) return;
+        byte first = MFRC522::MIFARE_SectorFirstBlock(RFID_RECORD_SECTOR);
+        if (rfid.MIFARE_Read(first, block, &size) != MFRC522::STATUS_OK) return;
+    } else {
+        return;
+    }
+    if (!tagRecord.decode(block, uid) && block[0] == 'R' && block[1] == 'T') {
+        Serial.println("RFID: enregistrement tag invalide (version/CRC) -> API");
+    }
+    if (tagRecord.valid()) {
+        Serial.printf("RFID: enregistrement tag -> entrepot %u (%c), station %u, %u ecritures\n",
+                      tagRecord.warehouse, tagRecord.store ? tagRecord.store : '?',
+                      tagRecord.station, tagRecord.writes);
+    }
+}
+
+// Detection + anticollision en un seul appel ; wakeup = WUPA des la 1re tentative
+// Sans wakeup : mode basse consommation automatique apres RFID_IDLE_TIMEOUT
+// status (optionnel) : STATUS_TIMEOUT = aucun tag dans le champ
+bool readRFIDTag(TagUid* uid, bool wakeup = false, byte* status = NULL) {
+    rfid.PCD_ResetBusStats();
+    byte result;
+    if (wakeup) {
+        result = rfid.PICC_DetectAndSelect(&rfid.uid, true, RFID_RETRIES, RFID_FIELD_RESET_MS);
+    } else {
+        bool wasIdle = rfid.PCD_InLowPower();
+        result = rfid.PICC_DetectAndSelectLowPower(&rfid.uid, RFID_RETRIES, RFID_FIELD_RESET_MS);
+        if (!wasIdle && rfid.PCD_InLowPower()) {
+            Serial.println("RFID: aucun tag, passage en basse consommation");
+        } else if (wasIdle && !rfid.PCD_InLowPower()) {
+            logLowPowerWake();
+        }
+    }
+    if (status) *status = result;
+    if (result != MFRC522::STATUS_OK) return false;
+    // tagDetectedAt fixe par l'appelant ; avant les lectures de donnees du tag
+    Serial.printf("RFID: detection -> UID en %lu us\n", micros() - tagDetectedAt);
+
+    // Cout bus I2C detection -> UID (transactions / octets)
+    MFRC522::BusStats stats = rfid.PCD_GetBusStats();
+    Serial.printf("RFID bus: %u transactions, %u octets\n",
+                  (unsigned)stats.transactions, (unsigned)stats.bytes);
+    if (stats.errors > 0) {
+        Serial.printf("RFID bus: %u erreurs I2C\n", (unsigned)stats.errors);
+    }
+    if (RFID_SHADOW_VERIFY && rfid.PCD_GetShadowMismatches() > 0) {
+        Serial.printf("RFID shadow: %u ecarts avec la puce\n", rfid.PCD_GetShadowMismatches());
+    }
+
+    *uid = TagUid(rfid.uid.uidByte, rfid.uid.size);
+
+    byte piccType = rfid.PICC_GetType(rfid.uid.sak);
+#if RFID_PAYLOAD_SECTORS > 0
+    tagPayloadLen = 0;
+    if (piccType == MFRC522::PICC_TYPE_MIFARE_1K || piccType == MFRC522::PICC_TYPE_MIFARE_4K) {
+        readTagPayload();
+    }
+#endif
+    readRouteRecord(piccType);
 
     rfid.PICC_HaltA();
     rfid.PCD_StopCrypto1();
 
-    return uid;
+    return true;
 }
 
 // ============================================================================
@@ -367,6 +860,7 @@ bool connectWiFi() {
         Serial.println();
         Serial.print("WiFi OK - IP: ");
         Serial.println(WiFi.localIP());
+        configTime(0, 0, "pool.ntp.org");  // Horodatage des enregistrements tag
         return true;
     }
 
@@ -378,26 +872,17 @@ bool connectWiFi() {
 // ROUTING API (RFID -> warehouse)
 // ============================================================================
 
-String normalizeUID(String uid) {
-    uid.trim();
-    uid.toUpperCase();
-    uid.replace(":", "");
-    uid.replace(" ", "");
-    return uid;
-}
-
-int queryWarehouseByUID(const String& uidRaw) {
+// UID en hexa majuscules sans separateur : "04823A11..."
+int queryWarehouseByUID(const TagUid& uid) {
     if (WiFi.status() != WL_CONNECTED) return -1;
 
-    String uid = normalizeUID(uidRaw);
+    char hex[TagUid::HEX_BUFFER_SIZE];
+    uid.toHex(hex, sizeof(hex));
 
     HTTPClient http;
-    String url = "http://";
-    url += ROUTING_API_HOST;
-    url += ":";
-    url += String(ROUTING_API_PORT);
-    url += "/api/routing/by-rfid/";
-    url += uid;
+    char url[128];
+    snprintf(url, sizeof(url), "http://%s:%d/api/routing/by-rfid/%s",
+             ROUTING_API_HOST, ROUTING_API_PORT, hex);
 
     Serial.print("ROUTING API GET: ");
     Serial.println(url);
@@ -457,6 +942,8 @@ void handleInit() {
         }
     }
 
+    parcels.clear();  // Reinit : plus de suivi des colis deja sur le tapis
+
     rfidOK = initRFID();
     grblOK = initGRBL();
     servoOK = initServo();
@@ -477,16 +964,59 @@ void handleInit() {
     }
 }
 
+// UID acquis : arret du tapis et passage a l'appel API
+// Doublon (tag reste dans le champ ou revenu sur le tapis) : ignore, pas
+// de 2e appel API ni de 2e mouvement servo
+void onTagRead(const TagUid& uid) {
+    char hex[TagUid::HEX_BUFFER_SIZE];
+    uid.toHex(hex, sizeof(hex), ':');
+
+    if (uidCache.checkAndInsert(uid, millis())) {
+        Serial.printf("UID deja traite: %s\n", hex);
+        Serial.printf("Cache UID: %u doublons evites, %u nouveaux\n",
+                      (unsigned)uidCache.hits(), (unsigned)uidCache.misses());
+        if (currentState != STATE_READY) setState(STATE_READY);
+        return;
+    }
+
+    currentUID = uid;
+    currentStore = "";
+    tagReadMm = beltEstimateMm();  // Dernier rapport sonde, sans attente
+    Serial.printf("UID lu: %s (tapis %.1f mm)\n", hex, tagReadMm);
+    M5.Speaker.tone(1200, 100);
+
+    // Ralentir le tapis MAINTENANT (juste avant l'appel API) : le tag reste
+    // dans le champ le temps de la decision, sans arret
+    beltSetOverride(BELT_READ_OVERRIDE);
+    displayStatus("Tag lu - Appel API...", CYAN);
+
+    displayState();
+    setState(STATE_QUERYING);
+}
+
 void handleReady() {
-    // Demarrer le tapis lentement si pas deja en marche
-    if (!conveyorRunning) {
-        conveyorStartSlow();
+    if (conveyorRunEnded()) {
+        Serial.println("Tapis: fin du G1 de marche continue -> relance");
+        conveyorRunning = false;
+    }
+    // Demarrer le tapis lentement si pas deja en marche (GRBL en Idle)
+    if (!conveyorRunning && conveyorStartSlow()) {
         displayStatus("PRET - Tapis en marche", GREEN);
     }
-
-    // Scanner RFID pendant que le tapis tourne
-    if (rfid.PICC_IsNewCardPresent()) {
-        // Tag detecte -> on passe directement en lecture (tapis tourne encore)
+    beltSetOverride(BELT_CRUISE_OVERRIDE);  // Lecteur vide : vitesse de croisiere
+
+    // Scanner RFID pendant que le tapis tourne : detection + UID en un passage
+    tagDetectedAt = micros();  // Debut de la sonde = detection si un tag repond
+    byte status;
+    TagUid uid;
+    if (readRFIDTag(&uid, false, &status)) {
+        onTagRead(uid);
+        return;
+    }
+    if (status != MFRC522::STATUS_TIMEOUT) {
+        // Tag vu mais UID illisible -> relances en lecture (tapis ralenti),
+        // detection -> UID mesure jusqu'a la relance reussie
+        beltSetOverride(BELT_READ_OVERRIDE);
         M5.Speaker.tone(800, 100);
         setState(STATE_READING);
         return;
@@ -528,28 +1058,22 @@ void handleReading() {
     displayStatus("Lecture RFID...", MAGENTA);
 
     unsigned long start = millis();
-    currentUID = "";
+    currentUID.clear();
     currentStore = "";
     int attempts = 0;
 
+    // Relances immediates en WUPA (le tag a deja repondu une fois)
     while (millis() - start < RFID_SCAN_TIMEOUT) {
         attempts++;
 
-        currentUID = readRFIDTag();
-        if (currentUID.length() > 0) {
-            Serial.println("UID lu: " + currentUID);
-            M5.Speaker.tone(1200, 100);
-
-            // Arreter le tapis MAINTENANT (juste avant l'appel API)
-            conveyorStop();
-            displayStatus("Tag lu - Appel API...", CYAN);
-
-            displayState();
-            setState(STATE_QUERYING);
+        TagUid uid;
+        if (readRFIDTag(&uid, true)) {
+            Serial.printf("RFID: lu apres %d tentatives\n", attempts);
+            onTagRead(uid);
             return;
         }
 
-        delay(250);
+        yield();
     }
 
     Serial.printf("RFID: Echec apres %d tentatives\n", attempts);
@@ -557,65 +1081,204 @@ void handleReading() {
     setState(STATE_ERROR);
 }
 
+// Decision deja sur le tag (CRC valide, entrepot connu) : pas d'appel API
 void handleQuerying() {
+    parcelsRouted++;
+
+    if (RFID_RECORD_ROUTING && tagRecord.valid() && tagRecord.warehouse <= 3) {
+        targetWarehouse = tagRecord.warehouse;
+        currentStore = tagRecord.store ? String(tagRecord.store) : "";
+        routeConfirmed = true;
+        parcelsOffline++;
+        Serial.printf("Tag -> Entrepot %d (hors ligne, %u/%u colis sans reseau)\n", targetWarehouse,
+                      (unsigned)parcelsOffline, (unsigned)parcelsRouted);
+        setState(STATE_ROUTING);
+        return;
+    }
+
+    Serial.printf("Routage hors ligne: %u/%u colis\n", (unsigned)parcelsOffline, (unsigned)parcelsRouted);
     displayStatus("Routing API...", CYAN);
 
     targetWarehouse = queryWarehouseByUID(currentUID);
 
     if (targetWarehouse > 0) {
         Serial.printf("UID -> Entrepot %d\n", targetWarehouse);
+        routeConfirmed = true;
         setState(STATE_ROUTING);
     } else {
         Serial.println("Routing API KO - Mode degrade (B)");
         targetWarehouse = 2; // B (centre)
         currentStore = "B";
+        routeConfirmed = false;  // Ne pas figer le mode degrade sur le tag
         setState(STATE_ROUTING);
     }
+}
 
-    // Reponse API recue -> passer directement au routing (redemarrage tapis)
-    setState(STATE_ROUTING);
+// Decision ecrite sur le tag (tapis ralenti a BELT_READ_OVERRIDE, tag encore
+// dans le champ) : WUPA + selection de son UID, puis MIFARE_Write du bloc 0 de
+// RFID_RECORD_SECTOR (Classic) ou des pages tagRecordPage.. (Ultralight/NTAG).
+// Les stations suivantes routent alors sans appel API.
+bool writeRouteRecord() {
+    // Tag deja sorti de la zone lecteur (API lente) : pas de tentative
+    float travelled = beltEstimateMm() - tagReadMm;
+    if (travelled > RFID_FIELD_MM) {
+        Serial.printf("RFID: tag sorti du champ (%.1f mm), decision non ecrite\n", travelled);
+        return false;
+    }
+
+    RouteRecord record;
+    record.store = currentStore.length() ? currentStore[0] : 0;
+    record.warehouse = targetWarehouse;
+    record.station = STATION_ID;
+    record.writes = tagRecord.valid() ? tagRecord.writes + 1 : 1;
+    time_t now = time(NULL);
+    record.timestamp = now > 1600000000 ? (uint32_t)now : 0;  // 0 = heure NTP absente
+    byte data[RouteRecord::SIZE];
+    record.encode(data, currentUID);
+
+    unsigned long start = micros();
+    MFRC522::Uid tag;
+    memset(&tag, 0, sizeof(tag));
+    tag.size = currentUID.size;
+    memcpy(tag.uidByte, currentUID.bytes, currentUID.size);
+
+    byte bufferATQA[2];
+    byte atqaSize = sizeof(bufferATQA);
+    byte result = rfid.PICC_WakeupA(bufferATQA, &atqaSize);
+    if (result == MFRC522::STATUS_OK) result = rfid.PICC_Select(&tag, tag.size * 8);
+    if (result == MFRC522::STATUS_OK) {
+        rfid.uid = tag;
+        byte piccType = rfid.PICC_GetType(tag.sak);
+        if (piccType == MFRC522::PICC_TYPE_MIFARE_1K || piccType == MFRC522::PICC_TYPE_MIFARE_4K) {
+            result = rfid.MIFARE_AuthenticateSector(RFID_RECORD_SECTOR);
+            if (result == MFRC522::STATUS_OK) {
+                byte block = MFRC522::MIFARE_SectorFirstBlock(RFID_RECORD_SECTOR);
+                result = rfid.MIFARE_Write(block, data, sizeof(data));
+            }
+        } else if (piccType == MFRC522::PICC_TYPE_MIFARE_UL && tagRecordPage != 0) {
+            for (byte i = 0; i < RouteRecord::SIZE / 4 && result == MFRC522::STATUS_OK; i++) {
+                result = rfid.MIFARE_Ultralight_Write(tagRecordPage + i, &data[i * 4], 4);
+            }
+        } else {
+            result = MFRC522::STATUS_INVALID;  // Type de tag sans ecriture geree
+        }
+    }
+    rfid.PICC_HaltA();
+    rfid.PCD_StopCrypto1();
+
+    unsigned long elapsedUs = micros() - start;
+    if (result == MFRC522::STATUS_OK) {
+        Serial.printf("RFID: decision ecrite sur le tag en %lu us\n", elapsedUs);
+    } else {
+        Serial.printf("RFID: ecriture tag echouee (%s) apres %lu us\n",
+                      (const char*)rfid.GetStatusCodeName(result), elapsedUs);
+    }
+    if (elapsedUs > RFID_RECORD_BUDGET_MS * 1000UL) {
+        Serial.printf("RFID: ecriture au-dela de %d ms\n", RFID_RECORD_BUDGET_MS);
+    }
+    return result == MFRC522::STATUS_OK;
 }
 
+int warehouseAngle(int warehouse) {
+    switch (warehouse) {
+        case 1: return WAREHOUSE_A_ANGLE;
+        case 2: return WAREHOUSE_B_ANGLE;
+        case 3: return WAREHOUSE_C_ANGLE;
+        default: return DEFAULT_ANGLE;
+    }
+}
+
+// Decision ecrite sur le tag puis colis mis en file avec sa position de
+// lecture : le servo est commande par serviceDiverter(), le lecteur est
+// aussitot libre pour le colis suivant
 void handleRouting() {
+    if (parcels.full()) {
+        static unsigned long lastLog = 0;
+        if (millis() - lastLog > 1000) {
+            lastLog = millis();
+            Serial.printf("File colis pleine (%d) - attente sortie aiguillage\n", PARCEL_QUEUE_SIZE);
+        }
+        return;
+    }
     displayStatus("Aiguillage...", YELLOW);
 
-    int angle = DEFAULT_ANGLE;
-    switch (targetWarehouse) {
-        case 1: angle = WAREHOUSE_A_ANGLE; break;
-        case 2: angle = WAREHOUSE_B_ANGLE; break;
-        case 3: angle = WAREHOUSE_C_ANGLE; break;
-        default: angle = DEFAULT_ANGLE; break;
+    // Tag encore dans le champ (tapis ralenti) : decision sur le tag (deja a jour = pas d'ecriture)
+    bool upToDate = tagRecord.valid() && tagRecord.warehouse == targetWarehouse &&
+                    tagRecord.station == STATION_ID;
+    if (RFID_RECORD_WRITE && routeConfirmed && !upToDate) writeRouteRecord();
+
+    // Servo encore pris par le colis precedent quand celui-ci passera son point de commande
+    if (parcels.wouldBeLate(tagReadMm)) {
+        Serial.printf("Colis a %.1f mm du precedent : aiguillage en retard probable\n",
+                      tagReadMm - parcels.at(parcels.size() - 1).readMm);
     }
 
-    // 1. Positionner le servo AVANT de redemarrer le tapis
-    Serial.printf("Entrepot %d (%s) -> Servo %d deg\n", targetWarehouse, currentStore.c_str(), angle);
-    setServoAngle(SERVO_CH1, angle);
-    delay(SERVO_MOVE_DELAY);  // 500ms pour que le servo atteigne sa position
+    Parcel parcel;
+    parcel.uid = currentUID;
+    parcel.warehouse = targetWarehouse;
+    parcel.store = currentStore.length() ? currentStore[0] : 0;
+    parcel.readMm = tagReadMm;
+    parcel.readAtMs = millis();
+    parcels.push(parcel);
+    Serial.printf("Entrepot %d (%s) -> aiguillage a %.1f mm (%u colis en cours)\n", targetWarehouse,
+                  currentStore.c_str(), tagReadMm + DIVERTER_OFFSET_MM, parcels.size());
 
-    // 2. Redemarrer le tapis IMMEDIATEMENT des reception reponse API
-    //    Pas de timer : le redemarrage est directement lie a la reponse API
     String label = "Entrepot " + currentStore;
     displayStatus(label.c_str(), GREEN);
-    conveyorStartSlow();      // Demarrage lent - tapis repart sans delai
     M5.Speaker.tone(1500, 200);
 
-    // 3. Laisser le colis passer devant l'aiguillage
-    delay(10000);  // 10s - le colis a le temps de passer avant retour servo
-
-    // 4. Remettre le servo en position neutre apres le passage du colis
-    Serial.println("Servo -> position neutre");
-    setServoAngle(SERVO_CH1, DEFAULT_ANGLE);
-    delay(SERVO_MOVE_DELAY);  // 500ms pour que le servo revienne
-
-    currentUID = "";
+    currentUID.clear();
     currentStore = "";
     targetWarehouse = 2;
+    routeConfirmed = false;
+    tagRecord.clear();
 
-    // conveyorRunning deja true (set dans conveyorStartSlow)
-    // handleReady ne relancera pas le tapis puisque conveyorRunning == true
+    // handleReady relance le tapis si besoin et repasse en vitesse de croisiere
     setState(STATE_READY);
 }
 
+// A chaque tour de loop, sur la position tapis des rapports GRBL (estimee a
+// la vitesse commandee s'ils manquent) : parcels.service() commande le servo
+// a DIVERTER_OFFSET_MM de la lecture du plus ancien colis et le sort de la
+// file a READER_TO_DIVERTER_MM. Tapis arrete : les colis attendent sur place.
+// Le colis suivant ne prend le servo qu'une fois le precedent sorti
+void serviceDiverter() {
+    static bool estimated = false;
+    if (!parcels.empty() && grblStatusStale() != estimated) {
+        estimated = !estimated;
+        Serial.println(estimated ? "Rapports GRBL absents - position tapis estimee"
+                                 : "Rapports GRBL revenus - position tapis mesuree");
+    }
+    float position = beltEstimateMm();
+    for (;;) {
+        DiverterStep step = parcels.service(position);
+        if (step.action == DiverterStep::NONE) return;
+        const Parcel& parcel = step.parcel;
+
+        if (step.action == DiverterStep::SWITCH) {
+            int angle = warehouseAngle(parcel.warehouse);
+            Serial.printf("Colis -> entrepot %d : servo %d deg (tapis %.1f mm)\n",
+                          parcel.warehouse, angle, position);
+            if (step.late) {
+                Serial.printf("Servo en retard : colis a %.1f mm de sa lecture (servo pret avant %.1f mm)\n",
+                              position - parcel.readMm, DIVERTER_OFFSET_MM + DIVERTER_SETTLE_MM);
+            }
+            setServoAngle(SERVO_CH1, angle);
+            continue;
+        }
+
+        if (step.late) Serial.println("Colis passe avant le servo (saut de position tapis)");
+        parcelsDiverted++;
+        Serial.printf("Colis sorti vers %c en %lu ms (%u aiguilles, max %u en vol)\n",
+                      parcel.store ? parcel.store : '?', millis() - parcel.readAtMs,
+                      (unsigned)parcelsDiverted, parcels.maxSize());
+        if (parcels.empty()) {
+            Serial.println("Servo -> position neutre");
+            setServoAngle(SERVO_CH1, DEFAULT_ANGLE);
+        }
+    }
+}
+
 void handleError() {
     M5.Lcd.fillScreen(BLACK);
     M5.Lcd.setTextSize(2);
@@ -643,6 +1306,32 @@ void handleError() {
     }
 }
 
+// Commandes moniteur serie : "cal" = recalibrer le lecteur RFID (tapis a l'arret),
+// "grbl" = metriques de la file G-code
+void handleSerialCommand() {
+    static char line[16];
+    static byte len = 0;
+    while (Serial.available()) {
+        char c = Serial.read();
+        if (c != '\n' && c != '\r') {
+            if (len < sizeof(line) - 1) line[len++] = c;
+            continue;
+        }
+        line[len] = '\0';
+        len = 0;
+        if (strcmp(line, "cal") == 0 && rfidOK && currentState == STATE_READY) {
+            if (conveyorRunning) conveyorStop();
+            // Champ force (mode basse consommation = antenne coupee), puis veille retablie
+            rfid.PCD_SetLowPowerDetect(0, RFID_IDLE_PROBE_MS, RFID_IDLE_SETTLE_MS);
+            calibrateRFID();
+            rfid.PCD_SetLowPowerDetect(RFID_IDLE_TIMEOUT, RFID_IDLE_PROBE_MS, RFID_IDLE_SETTLE_MS);
+            displayState();
+        } else if (strcmp(line, "grbl") == 0) {
+            printGrblStats();
+        }
+    }
+}
+
 // ============================================================================
 // SETUP & LOOP
 // ============================================================================
@@ -673,6 +1362,9 @@ void setup() {
 
 void loop() {
     M5.update();
+    handleSerialCommand();
+    if (grblOK) grblStatusPoll();  // Etat/position + acquittements + suite de la file G-code
+    if (servoOK) serviceDiverter();  // Servo au passage de chaque colis en vol
 
     switch (currentState) {
         case STATE_INIT:      handleInit(); break;
@@ -0,0 +1,142 @@
+/**
+ * =============================================================================
+ * Test Unitaire - CRC_A logiciel (MFRC522)
+ * =============================================================================
+ * Projet : The Conveyor (T-IOT-901)
+ * Fichier : test/test_crc/test_crc.cpp
+ *
+ * Verifie que le CRC_A par table (utilise par defaut par le driver) donne
+ * exactement le resultat du coprocesseur CRC du MFRC522 (registre a decalage
+ * bit a bit, preset 0x6363), sur les vecteurs ISO 14443-3 et les trames
+ * envoyees par le driver.
+ * Executer avec : pio test -e native
+ * =============================================================================
+ */
+
+#include <unity.h>
+#include <string.h>
+#include "MFRC522_CRC.h"
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+// =============================================================================
+// Vecteurs de reference (ISO/IEC 14443-3 Annexe B)
+// =============================================================================
+
+void test_crc_iso_vector_0000(void) {
+    const uint8_t data[] = {0x00, 0x00};
+    uint8_t result[2];
+
+    MFRC522_CRC::compute(data, sizeof(data), result);
+
+    TEST_ASSERT_EQUAL_HEX8(0xA0, result[0]);
+    TEST_ASSERT_EQUAL_HEX8(0x1E, result[1]);
+}
+
+void test_crc_iso_vector_1234(void) {
+    const uint8_t data[] = {0x12, 0x34};
+    uint8_t result[2];
+
+    MFRC522_CRC::compute(data, sizeof(data), result);
+
+    TEST_ASSERT_EQUAL_HEX8(0x26, result[0]);
+    TEST_ASSERT_EQUAL_HEX8(0xCF, result[1]);
+}
+
+void test_crc_empty_is_preset(void) {
+    TEST_ASSERT_EQUAL_HEX16(0x6363, MFRC522_CRC::compute(NULL, 0));
+}
+
+// =============================================================================
+// Trames du driver (HLTA, READ, SELECT)
+// =============================================================================
+
+void test_crc_halt_frame(void) {
+    const uint8_t hlta[] = {0x50, 0x00};
+    uint8_t result[2];
+
+    MFRC522_CRC::compute(hlta, sizeof(hlta), result);
+
+    TEST_ASSERT_EQUAL_HEX8(0x57, result[0]);
+    TEST_ASSERT_EQUAL_HEX8(0xCD, result[1]);
+}
+
+void test_crc_select_frame_matches_bitwise(void) {
+    // SEL CL1, NVB 0x70, UID 04 82 3A 11, BCC
+    uint8_t select[7] = {0x93, 0x70, 0x04, 0x82, 0x3A, 0x11, 0x00};
+    select[6] = select[2] ^ select[3] ^ select[4] ^ select[5];
+
+    TEST_ASSERT_EQUAL_HEX16(MFRC522_CRC::computeBitwise(select, sizeof(select)),
+                            MFRC522_CRC::compute(select, sizeof(select)));
+}
+
+// =============================================================================
+// Table vs registre a decalage (comportement du coprocesseur)
+// =============================================================================
+
+void test_crc_every_single_byte(void) {
+    for (int b = 0; b < 256; b++) {
+        uint8_t data = (uint8_t)b;
+        TEST_ASSERT_EQUAL_HEX16(MFRC522_CRC::computeBitwise(&data, 1),
+                                MFRC522_CRC::compute(&data, 1));
+    }
+}
+
+void test_crc_fifo_sized_buffers(void) {
+    // Toutes les longueurs jusqu'a la taille de la FIFO (64 octets)
+    uint8_t data[64];
+    uint32_t seed = 0x12345678;
+    for (size_t i = 0; i < sizeof(data); i++) {
+        seed = seed * 1103515245u + 12345u;
+        data[i] = (uint8_t)(seed >> 16);
+    }
+    for (size_t len = 0; len <= sizeof(data); len++) {
+        TEST_ASSERT_EQUAL_HEX16(MFRC522_CRC::computeBitwise(data, len),
+                                MFRC522_CRC::compute(data, len));
+    }
+}
+
+void test_crc_incremental_update(void) {
+    const uint8_t data[] = {0x30, 0x04, 0xA0, 0x05, 0xDE, 0xAD};
+    uint16_t crc = MFRC522_CRC::update(MFRC522_CRC::PRESET, data, 2);
+    crc = MFRC522_CRC::update(crc, data + 2, sizeof(data) - 2);
+
+    TEST_ASSERT_EQUAL_HEX16(MFRC522_CRC::compute(data, sizeof(data)), crc);
+}
+
+void test_crc_frame_with_crc_checks_to_zero(void) {
+    // Une trame suivie de son CRC_A (LSB d'abord) donne un residu nul
+    uint8_t frame[4] = {0x30, 0x08, 0x00, 0x00};
+    MFRC522_CRC::compute(frame, 2, &frame[2]);
+
+    TEST_ASSERT_EQUAL_HEX16(0x0000, MFRC522_CRC::compute(frame, sizeof(frame)));
+}
+
+// =============================================================================
+// Point d'entrée des tests
+// =============================================================================
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+
+    // Vecteurs ISO
+    RUN_TEST(test_crc_iso_vector_0000);
+    RUN_TEST(test_crc_iso_vector_1234);
+    RUN_TEST(test_crc_empty_is_preset);
+
+    // Trames du driver
+    RUN_TEST(test_crc_halt_frame);
+    RUN_TEST(test_crc_select_frame_matches_bitwise);
+
+    // Table vs bit a bit
+    RUN_TEST(test_crc_every_single_byte);
+    RUN_TEST(test_crc_fifo_sized_buffers);
+    RUN_TEST(test_crc_incremental_update);
+    RUN_TEST(test_crc_frame_with_crc_checks_to_zero);
+
+    return UNITY_END();
+}
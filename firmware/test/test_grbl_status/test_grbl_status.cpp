@@ -0,0 +1,154 @@
+/**
+ * =============================================================================
+ * Test Unitaire - Rapport d'etat GRBL (GrblStatus)
+ * =============================================================================
+ * Projet : The Conveyor (T-IOT-901)
+ * Fichier : test/test_grbl_status/test_grbl_status.cpp
+ *
+ * Verifie le parsing des rapports '?' de GRBL 1.1 utilises par le sondage
+ * d'etat du firmware : etat et sous-etat, MPos / WPos + WCO, avance, tampons
+ * (Bf), overrides, champs absents conserves et lignes qui ne sont pas des
+ * rapports.
+ * Executer avec : pio test -e native
+ * =============================================================================
+ */
+
+#include <unity.h>
+#include "GrblStatus.h"
+
+static GrblStatus status;
+
+void setUp(void) {
+    status.clear();
+}
+
+void tearDown(void) {
+}
+
+// =============================================================================
+// Etat
+// =============================================================================
+
+void test_states(void) {
+    TEST_ASSERT_TRUE(status.parse("<Idle|MPos:0.000,0.000,0.000|FS:0,0>"));
+    TEST_ASSERT_EQUAL(GrblStatus::IDLE, status.state);
+    TEST_ASSERT_TRUE(status.stopped());
+
+    status.parse("<Run|MPos:0.000,0.000,1.000|FS:20,0>");
+    TEST_ASSERT_EQUAL(GrblStatus::RUN, status.state);
+    TEST_ASSERT_FALSE(status.stopped());
+
+    status.parse("<Jog|MPos:0.000,0.000,1.000|FS:3000,0>");
+    TEST_ASSERT_EQUAL(GrblStatus::JOG, status.state);
+
+    status.parse("<Alarm|MPos:0.000,0.000,1.000|FS:0,0>");
+    TEST_ASSERT_EQUAL(GrblStatus::ALARM, status.state);
+    TEST_ASSERT_FALSE(status.stopped());
+    TEST_ASSERT_EQUAL_STRING("Alarm", GrblStatus::stateName(status.state));
+}
+
+void test_hold_substate(void) {
+    // Hold:1 = decelere encore, Hold:0 = immobile
+    status.parse("<Hold:1|MPos:0.000,0.000,2.000|FS:12,0>");
+    TEST_ASSERT_EQUAL(GrblStatus::HOLD, status.state);
+    TEST_ASSERT_EQUAL_UINT8(1, status.subState);
+    TEST_ASSERT_FALSE(status.stopped());
+
+    status.parse("<Hold:0|MPos:0.000,0.000,2.010|FS:0,0>");
+    TEST_ASSERT_EQUAL_UINT8(0, status.subState);
+    TEST_ASSERT_TRUE(status.stopped());
+}
+
+void test_unknown_state(void) {
+    status.parse("<Idle|MPos:0.000,0.000,0.000|FS:0,0>");
+    status.parse("<Tool|MPos:0.000,0.000,0.000|FS:0,0>");
+    TEST_ASSERT_EQUAL(GrblStatus::UNKNOWN, status.state);
+    TEST_ASSERT_FALSE(status.stopped());
+}
+
+// =============================================================================
+// Champs
+// =============================================================================
+
+void test_position_feed_buffers_overrides(void) {
+    TEST_ASSERT_TRUE(status.parse(
+        "<Run|MPos:1.000,-2.500,12.345|Bf:14,112|FS:40,0|Ov:200,100,100>"));
+
+    TEST_ASSERT_EQUAL_FLOAT(1.0f, status.mpos[0]);
+    TEST_ASSERT_EQUAL_FLOAT(-2.5f, status.mpos[1]);
+    TEST_ASSERT_EQUAL_FLOAT(12.345f, status.mpos[2]);
+    TEST_ASSERT_EQUAL_FLOAT(40.0f, status.feed);
+    TEST_ASSERT_EQUAL_INT16(14, status.plannerFree);
+    TEST_ASSERT_EQUAL_INT16(112, status.rxFree);
+    TEST_ASSERT_EQUAL_UINT8(200, status.feedOverride);
+    TEST_ASSERT_EQUAL_UINT32(1, status.reports);
+}
+
+void test_missing_fields_keep_last_value(void) {
+    // Ov et WCO ne sont envoyes que tous les N rapports
+    status.parse("<Run|MPos:0.000,0.000,5.000|FS:20,0|Ov:150,100,100>");
+    status.parse("<Run|MPos:0.000,0.000,6.000|FS:20,0>");
+
+    TEST_ASSERT_EQUAL_FLOAT(6.0f, status.mpos[2]);
+    TEST_ASSERT_EQUAL_UINT8(150, status.feedOverride);
+    TEST_ASSERT_EQUAL_INT16(-1, status.plannerFree);  // Jamais recu ($10 sans Bf)
+}
+
+void test_work_position_is_turned_into_machine_position(void) {
+    status.parse("<Idle|WPos:0.000,0.000,3.000|FS:0,0|WCO:0.000,0.000,10.000>");
+    status.parse("<Idle|WPos:0.000,0.000,4.000|FS:0,0>");
+
+    TEST_ASSERT_EQUAL_FLOAT(14.0f, status.mpos[2]);
+}
+
+void test_feed_only_report(void) {
+    // GRBL sans broche variable : F: au lieu de FS:
+    status.parse("<Run|MPos:0.000,0.000,0.000|F:500>");
+    TEST_ASSERT_EQUAL_FLOAT(500.0f, status.feed);
+}
+
+void test_malformed_field_is_ignored(void) {
+    status.parse("<Run|MPos:0.000,0.000,7.000|FS:20,0>");
+    status.parse("<Run|MPos:1.000,2.000|FS:20,0|Pn:Z>");
+
+    TEST_ASSERT_EQUAL_FLOAT(7.0f, status.mpos[2]);
+    TEST_ASSERT_EQUAL(GrblStatus::RUN, status.state);
+}
+
+// =============================================================================
+// Lignes qui ne sont pas des rapports
+// =============================================================================
+
+void test_other_lines_are_not_reports(void) {
+    TEST_ASSERT_FALSE(status.parse("ok"));
+    TEST_ASSERT_FALSE(status.parse("[MSG:Caution: Unlocked]"));
+    TEST_ASSERT_FALSE(status.parse("<Run|MPos:0.000,0.000,1.000"));  // Tronquee
+    TEST_ASSERT_FALSE(status.parse(""));
+    TEST_ASSERT_EQUAL_UINT32(0, status.reports);
+    TEST_ASSERT_EQUAL(GrblStatus::UNKNOWN, status.state);
+}
+
+// =============================================================================
+// Point d'entrée des tests
+// =============================================================================
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+
+    // Etat
+    RUN_TEST(test_states);
+    RUN_TEST(test_hold_substate);
+    RUN_TEST(test_unknown_state);
+
+    // Champs
+    RUN_TEST(test_position_feed_buffers_overrides);
+    RUN_TEST(test_missing_fields_keep_last_value);
+    RUN_TEST(test_work_position_is_turned_into_machine_position);
+    RUN_TEST(test_feed_only_report);
+    RUN_TEST(test_malformed_field_is_ignored);
+
+    // Autres lignes
+    RUN_TEST(test_other_lines_are_not_reports);
+
+    return UNITY_END();
+}
@@ -0,0 +1,284 @@
+/**
+ * =============================================================================
+ * Test Unitaire - File d'envoi G-code GRBL (GrblStream)
+ * =============================================================================
+ * Projet : The Conveyor (T-IOT-901)
+ * Fichier : test/test_grbl_stream/test_grbl_stream.cpp
+ *
+ * Fait tourner GrblStream sur une liaison simulee qui joue GRBL : tampon RX
+ * de 128 octets (debordement detecte), lignes consommees a la demande et
+ * reponses ok / error:N / ALARM:N / banniere. Verifie le comptage des
+ * caracteres, l'ordre des acquittements, le reset et les metriques.
+ * Executer avec : pio test -e native
+ * =============================================================================
+ */
+
+#include <unity.h>
+#include <string.h>
+#include "GrblStream.h"
+
+// GRBL simule : ce que l'hote a ecrit et ce que GRBL renverra
+struct FakeGrbl {
+    char rx[1024];      // Tout ce qui a ete recu
+    uint16_t rxLength;
+    uint16_t consumed;  // Octets sortis du tampon RX (lignes executees)
+    uint16_t maxPending;
+    uint8_t writes;
+    char tx[256];       // Reponses en attente de lecture
+    uint16_t txLength;
+    uint16_t txPos;
+};
+
+static FakeGrbl fake;
+
+struct FakeLink {
+    void write(const char *data, uint8_t length) {
+        memcpy(&fake.rx[fake.rxLength], data, length);
+        fake.rxLength += length;
+        fake.writes++;
+        uint16_t pending = fake.rxLength - fake.consumed;
+        if (pending > fake.maxPending) fake.maxPending = pending;
+    }
+    uint8_t read(char *buffer, uint8_t size) {
+        uint8_t n = 0;
+        while (n < size && fake.txPos < fake.txLength) buffer[n++] = fake.tx[fake.txPos++];
+        while (n < size) buffer[n++] = (char)0xFF;  // Bourrage I2C
+        return n;
+    }
+};
+
+typedef GrblStream<FakeLink, 16> Stream;
+static Stream *grbl = NULL;
+
+// GRBL execute la prochaine ligne recue et repond
+static void grblReplies(const char *reply) {
+    while (fake.consumed < fake.rxLength && fake.rx[fake.consumed] != '\n') fake.consumed++;
+    fake.consumed++;
+    size_t length = strlen(reply);
+    memcpy(&fake.tx[fake.txLength], reply, length);
+    fake.txLength += length;
+    fake.tx[fake.txLength++] = '\r';
+    fake.tx[fake.txLength++] = '\n';
+}
+
+static void grblSays(const char *message) {
+    size_t length = strlen(message);
+    memcpy(&fake.tx[fake.txLength], message, length);
+    fake.txLength += length;
+    fake.tx[fake.txLength++] = '\n';
+}
+
+static uint16_t linesReceived() {
+    uint16_t lines = 0;
+    for (uint16_t i = 0; i < fake.rxLength; i++) {
+        if (fake.rx[i] == '\n') lines++;
+    }
+    return lines;
+}
+
+static char lastLine[80];
+static void onLine(const char *line, void *) {
+    strcpy(lastLine, line);
+}
+
+void setUp(void) {
+    static Stream instance((FakeLink()));
+    memset(&fake, 0, sizeof(fake));
+    grbl = &instance;
+    grbl->reset();
+    grbl->resetStats();
+    grbl->setLineHandler(onLine);
+    lastLine[0] = '\0';
+}
+
+void tearDown(void) {
+}
+
+// =============================================================================
+// Comptage des caracteres
+// =============================================================================
+
+void test_lines_sent_without_waiting_for_ok(void) {
+    TEST_ASSERT_TRUE(grbl->send("G91", 0));
+    TEST_ASSERT_TRUE(grbl->send("G1 Z50 F3000", 0));
+    TEST_ASSERT_TRUE(grbl->send("G90", 0));
+
+    TEST_ASSERT_EQUAL_UINT16(3, linesReceived());
+    TEST_ASSERT_EQUAL_UINT8(4 + 13 + 4, grbl->inFlight());
+    TEST_ASSERT_EQUAL_UINT8(3, grbl->depth());
+    TEST_ASSERT_FALSE(grbl->idle());
+}
+
+void test_rx_buffer_never_overflows(void) {
+    // 16 lignes de 40 octets : 3 tiennent dans 128, la suite attend les ok
+    char line[40];
+    memset(line, 'X', 39);
+    line[0] = 'G';
+    line[39] = '\0';
+    for (int i = 0; i < 16; i++) TEST_ASSERT_TRUE(grbl->send(line, 0));
+
+    TEST_ASSERT_EQUAL_UINT16(3, linesReceived());
+    TEST_ASSERT_EQUAL_UINT8(16, grbl->depth());
+    TEST_ASSERT_FALSE(grbl->send("G90", 0));  // File pleine
+
+    for (int i = 0; i < 16; i++) {
+        grblReplies("ok");
+        grbl->poll(0);
+        TEST_ASSERT_TRUE(fake.maxPending <= Stream::RX_BUFFER_SIZE);
+    }
+    TEST_ASSERT_EQUAL_UINT16(16, linesReceived());
+    TEST_ASSERT_TRUE(grbl->idle());
+    TEST_ASSERT_EQUAL_UINT8(120, grbl->stats().maxInFlight);
+}
+
+void test_queued_lines_go_out_in_one_write(void) {
+    char line[40];
+    memset(line, 'X', 39);
+    line[0] = 'G';
+    line[39] = '\0';
+    grbl->send(line, 0);
+    grbl->send(line, 0);
+    grbl->send(line, 0);  // 120 octets en vol
+    grbl->send(line, 0);
+    grbl->send("G91", 0);
+    grbl->send("G90", 0);
+    uint8_t writes = fake.writes;
+    TEST_ASSERT_EQUAL_UINT16(3, linesReceived());
+
+    grblReplies("ok");
+    grbl->poll(0);
+
+    TEST_ASSERT_EQUAL_UINT8(writes + 1, fake.writes);
+    TEST_ASSERT_EQUAL_UINT16(6, linesReceived());
+}
+
+void test_too_long_line_is_refused(void) {
+    char line[Stream::LINE_SIZE + 1];
+    memset(line, 'G', sizeof(line) - 1);
+    line[sizeof(line) - 1] = '\0';
+
+    TEST_ASSERT_FALSE(grbl->send(line, 0));
+    TEST_ASSERT_TRUE(grbl->idle());
+    TEST_ASSERT_EQUAL_UINT16(0, fake.rxLength);
+}
+
+// =============================================================================
+// Reponses
+// =============================================================================
+
+void test_ok_acknowledges_in_order(void) {
+    grbl->send("G91", 0);
+    grbl->send("G1 Z50 F3000", 0);
+    grblReplies("ok");
+    grbl->poll(0);
+
+    TEST_ASSERT_EQUAL_UINT8(1, grbl->depth());
+    TEST_ASSERT_EQUAL_UINT8(13, grbl->inFlight());
+    TEST_ASSERT_EQUAL_UINT32(1, grbl->stats().acked);
+}
+
+void test_error_acknowledges_and_names_the_line(void) {
+    grbl->send("G91", 0);
+    grbl->send("G1 Z50 F", 0);
+    grblReplies("ok");
+    grblReplies("error:2");
+    grbl->poll(0);
+
+    TEST_ASSERT_TRUE(grbl->idle());
+    TEST_ASSERT_EQUAL_UINT32(1, grbl->stats().errors);
+    TEST_ASSERT_EQUAL_INT(2, grbl->lastError());
+    TEST_ASSERT_EQUAL_STRING("G1 Z50 F", grbl->lastErrorLine());
+}
+
+void test_alarm_is_not_an_acknowledgement(void) {
+    grbl->send("G1 Z50 F3000", 0);
+    grblSays("ALARM:1");
+    grbl->poll(0);
+
+    TEST_ASSERT_EQUAL_UINT8(1, grbl->depth());
+    TEST_ASSERT_EQUAL_UINT32(1, grbl->stats().alarms);
+    TEST_ASSERT_EQUAL_INT(1, grbl->lastAlarm());
+}
+
+void test_reply_split_across_reads(void) {
+    // 12 acquittements (48 octets) : un "ok\r\n" chevauche deux lectures de 32
+    for (int i = 0; i < 12; i++) {
+        grbl->send("G90", 0);
+        grblReplies("ok");
+    }
+    grbl->poll(0);
+    TEST_ASSERT_EQUAL_UINT32(8, grbl->stats().acked);
+    grbl->poll(0);
+
+    TEST_ASSERT_TRUE(grbl->idle());
+    TEST_ASSERT_EQUAL_UINT32(12, grbl->stats().acked);
+}
+
+void test_other_lines_go_to_the_handler(void) {
+    grblSays("[MSG:'$H'|'$X' to unlock]");
+    grbl->poll(0);
+
+    TEST_ASSERT_EQUAL_STRING("[MSG:'$H'|'$X' to unlock]", lastLine);
+}
+
+// =============================================================================
+// Reset et metriques
+// =============================================================================
+
+void test_reset_drops_the_queue_and_waits_for_banner(void) {
+    grbl->send("G1 Z5000 F20", 0);
+    grbl->reset();
+    TEST_ASSERT_TRUE(grbl->idle());
+    TEST_ASSERT_FALSE(grbl->bannerSeen());
+
+    grblSays("ok");  // Reponse a une ligne d'avant le reset : ignoree
+    grblSays("Grbl 1.1h ['$' for help]");
+    grbl->poll(0);
+
+    TEST_ASSERT_TRUE(grbl->bannerSeen());
+    TEST_ASSERT_EQUAL_UINT32(0, grbl->stats().acked);
+    TEST_ASSERT_EQUAL_STRING("", lastLine);
+}
+
+void test_latency_and_depth_metrics(void) {
+    grbl->send("G91", 1000);
+    grbl->send("G90", 1000);
+    grblReplies("ok");
+    grbl->poll(1800);
+    grblReplies("ok");
+    grbl->poll(3000);
+
+    const Stream::Stats &stats = grbl->stats();
+    TEST_ASSERT_EQUAL_UINT32(2, stats.sent);
+    TEST_ASSERT_EQUAL_UINT32(2000, stats.lastLatencyUs);
+    TEST_ASSERT_EQUAL_UINT32(2000, stats.maxLatencyUs);
+    TEST_ASSERT_EQUAL_UINT32(1400, grbl->averageLatencyUs());
+    TEST_ASSERT_EQUAL_UINT8(2, stats.maxDepth);
+}
+
+// =============================================================================
+// Point d'entrée des tests
+// =============================================================================
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+
+    // Comptage des caracteres
+    RUN_TEST(test_lines_sent_without_waiting_for_ok);
+    RUN_TEST(test_rx_buffer_never_overflows);
+    RUN_TEST(test_queued_lines_go_out_in_one_write);
+    RUN_TEST(test_too_long_line_is_refused);
+
+    // Reponses
+    RUN_TEST(test_ok_acknowledges_in_order);
+    RUN_TEST(test_error_acknowledges_and_names_the_line);
+    RUN_TEST(test_alarm_is_not_an_acknowledgement);
+    RUN_TEST(test_reply_split_across_reads);
+    RUN_TEST(test_other_lines_go_to_the_handler);
+
+    // Reset et metriques
+    RUN_TEST(test_reset_drops_the_queue_and_waits_for_banner);
+    RUN_TEST(test_latency_and_depth_metrics);
+
+    return UNITY_END();
+}
@@ -0,0 +1,158 @@
+/**
+ * =============================================================================
+ * Test Unitaire - Driver MFRC522 sur bus simule
+ * =============================================================================
+ * Projet : The Conveyor (T-IOT-901)
+ * Fichier : test/test_mfrc522_bus/test_mfrc522_bus.cpp
+ *
+ * Fait tourner le driver MFRC522 (lib/MFRC522) sur MFRC522_MockBus et compte
+ * les transactions bus par operation. Les valeurs attendues sont celles du
+ * driver actuel : une hausse signale une regression de performance I2C.
+ * Executer avec : pio test -e native
+ * =============================================================================
+ */
+
+#include <unity.h>
+#include "MFRC522_I2C.h"
+
+typedef MFRC522Base<MFRC522_MockBus> MockMFRC522;
+
+static MockMFRC522 *rfid = NULL;
+
+static MFRC522_MockBus &bus() { return rfid->PCD_GetBus(); }
+
+void setUp(void) {
+    static MockMFRC522 instance((MFRC522_MockBus()));
+    rfid = &instance;
+    bus().reset();
+    rfid->PCD_Init();
+    bus().clearLog();
+    rfid->PCD_ResetBusStats();
+}
+
+void tearDown(void) {
+}
+
+// =============================================================================
+// Acces registres
+// =============================================================================
+
+void test_write_register_is_one_transaction(void) {
+    rfid->PCD_WriteRegister(MFRC522Defs::ModeReg, 0x3D);
+
+    TEST_ASSERT_EQUAL_UINT32(1, bus().transactions());
+    TEST_ASSERT_TRUE(bus().logEntry(0).write);
+    TEST_ASSERT_EQUAL_HEX8(MFRC522Defs::ModeReg, bus().logEntry(0).reg);
+    TEST_ASSERT_EQUAL_HEX8(0x3D, bus().registers[MFRC522Defs::ModeReg]);
+}
+
+void test_batch_is_one_transaction(void) {
+    byte data[] = {0x26, 0x52};
+
+    rfid->PCD_BeginBatch();
+    rfid->PCD_WriteRegister(MFRC522Defs::CommandReg, MFRC522Defs::PCD_Idle);
+    rfid->PCD_WriteRegister(MFRC522Defs::FIFOLevelReg, 0x80);
+    rfid->PCD_WriteRegister(MFRC522Defs::FIFODataReg, 1, &data[0]);
+    rfid->PCD_WriteRegister(MFRC522Defs::FIFODataReg, 1, &data[1]);
+    rfid->PCD_EndBatch();
+
+    TEST_ASSERT_EQUAL_UINT32(1, bus().transactions());
+    TEST_ASSERT_EQUAL_UINT8(2, bus().fifoLength());
+    // 3 entrees (les 2 ecritures FIFO fusionnees) : 3 adresses + 4 octets
+    TEST_ASSERT_EQUAL_UINT32(7, rfid->PCD_GetBusStats().bytes);
+}
+
+void test_failed_batch_is_counted_as_error(void) {
+    bus().batchFails = true;
+
+    rfid->PCD_BeginBatch();
+    rfid->PCD_WriteRegister(MFRC522Defs::CommandReg, MFRC522Defs::PCD_Idle);
+    rfid->PCD_WriteRegister(MFRC522Defs::FIFOLevelReg, 0x80);
+    rfid->PCD_EndBatch();
+
+    MFRC522Defs::BusStats stats = rfid->PCD_GetBusStats();
+    TEST_ASSERT_EQUAL_UINT32(1, stats.errors);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.transactions);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.bytes);
+}
+
+void test_static_register_read_served_by_shadow(void) {
+    rfid->PCD_SetAntennaGain(MFRC522Defs::RxGain_max);
+    bus().clearLog();
+
+    TEST_ASSERT_EQUAL_HEX8(MFRC522Defs::RxGain_max, rfid->PCD_GetAntennaGain());
+    TEST_ASSERT_EQUAL_UINT32(0, bus().transactions());
+}
+
+void test_read_with_rx_align_keeps_low_bits(void) {
+    byte answer[] = {0xA5};
+    byte values[1] = {0x0F};
+    bus().loadFifo(answer, 1);
+
+    rfid->PCD_ReadRegister(MFRC522Defs::FIFODataReg, 1, values, 4);
+
+    TEST_ASSERT_EQUAL_HEX8(0xAF, values[0]);
+}
+
+// =============================================================================
+// Transactions par operation (metrique de regression)
+// =============================================================================
+
+void test_software_crc_has_no_bus_traffic(void) {
+    byte frame[] = {0x50, 0x00};
+    byte crc[2];
+
+    TEST_ASSERT_EQUAL(MFRC522Defs::STATUS_OK, rfid->PCD_CalculateCRC(frame, 2, crc));
+    TEST_ASSERT_EQUAL_UINT32(0, bus().transactions());
+}
+
+void test_init_transactions(void) {
+    bus().reset();
+    rfid->PCD_Init();
+
+    TEST_ASSERT_EQUAL_UINT32(9, bus().transactions());
+}
+
+void test_reqa_empty_field(void) {
+    byte atqa[2];
+    byte size = sizeof(atqa);
+
+    TEST_ASSERT_EQUAL(MFRC522Defs::STATUS_TIMEOUT, rfid->PICC_RequestA(atqa, &size));
+    TEST_ASSERT_EQUAL_UINT32(5, bus().transactions());
+    TEST_ASSERT_EQUAL_UINT32(bus().transactions(), rfid->PCD_GetBusStats().transactions);
+}
+
+void test_repeated_reqa_keeps_timeout_profile(void) {
+    byte atqa[2];
+    byte size = sizeof(atqa);
+    rfid->PICC_RequestA(atqa, &size);
+    bus().clearLog();
+
+    size = sizeof(atqa);
+    rfid->PICC_RequestA(atqa, &size);
+
+    TEST_ASSERT_EQUAL_UINT32(3, bus().transactions());
+}
+
+// =============================================================================
+// Point d'entrée des tests
+// =============================================================================
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+
+    // Acces registres
+    RUN_TEST(test_write_register_is_one_transaction);
+    RUN_TEST(test_batch_is_one_transaction);
+    RUN_TEST(test_failed_batch_is_counted_as_error);
+    RUN_TEST(test_static_register_read_served_by_shadow);
+    RUN_TEST(test_read_with_rx_align_keeps_low_bits);
+
+    // Transactions par operation
+    RUN_TEST(test_software_crc_has_no_bus_traffic);
+    RUN_TEST(test_init_transactions);
+    RUN_TEST(test_reqa_empty_field);
+    RUN_TEST(test_repeated_reqa_keeps_timeout_profile);
+
+    return UNITY_END();
+}
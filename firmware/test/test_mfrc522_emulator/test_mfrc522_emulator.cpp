@@ -0,0 +1,407 @@
+/**
+ * =============================================================================
+ * Test Unitaire - Driver MFRC522 sur emulateur puce + tags
+ * =============================================================================
+ * Projet : The Conveyor (T-IOT-901)
+ * Fichier : test/test_mfrc522_emulator/test_mfrc522_emulator.cpp
+ *
+ * Fait tourner le driver MFRC522 (lib/MFRC522) sur MFRC522_Emulator
+ * (lib/MFRC522_Emulator) : registres, FIFO, timer et IRQ de la puce, et des
+ * tags ISO 14443A virtuels dans le champ. Verifie la selection (UID 4/7/10
+ * octets, collisions), HALT/WUPA, les lectures/ecritures et les fautes
+ * (NAK, timeouts), puis mesure transactions et temps bus par operation.
+ * Executer avec : pio test -e native
+ * =============================================================================
+ */
+
+#include <unity.h>
+#include "MFRC522_Emulator.h"
+
+typedef MFRC522Base<MFRC522_Emulator> EmulatedMFRC522;
+typedef MFRC522_VirtualTag Tag;
+
+static EmulatedMFRC522 *rfid = NULL;
+
+static const byte UID4[] = {0xDE, 0xAD, 0xBE, 0xEF};
+static const byte UID7[] = {0x04, 0x82, 0x3A, 0x11, 0x22, 0x6C, 0x80};
+static const byte UID10[] = {0x04, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99};
+
+static MFRC522_Emulator &chip() { return rfid->PCD_GetBus(); }
+
+void setUp(void) {
+    static EmulatedMFRC522 instance((MFRC522_Emulator()));
+    rfid = &instance;
+    chip().removeTags();
+    chip().powerOn();
+    rfid->PCD_SetSoftwareCRC(true);
+    rfid->PCD_Init();
+    chip().resetStats();
+    rfid->PCD_ResetBusStats();
+}
+
+void tearDown(void) {
+}
+
+static void assertUid(const byte *expected, byte size, const MFRC522Defs::Uid &uid) {
+    TEST_ASSERT_EQUAL_UINT8(size, uid.size);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, uid.uidByte, size);
+}
+
+// =============================================================================
+// Selection
+// =============================================================================
+
+void test_empty_field_times_out(void) {
+    byte atqa[2];
+    byte size = sizeof(atqa);
+
+    TEST_ASSERT_EQUAL(MFRC522Defs::STATUS_TIMEOUT, rfid->PICC_RequestA(atqa, &size));
+}
+
+void test_select_4_byte_uid(void) {
+    chip().addTag(Tag::CLASSIC_1K, UID4, sizeof(UID4));
+    MFRC522Defs::Uid uid;
+
+    TEST_ASSERT_EQUAL(MFRC522Defs::STATUS_OK, rfid->PICC_DetectAndSelect(&uid));
+    assertUid(UID4, sizeof(UID4), uid);
+    TEST_ASSERT_EQUAL_HEX8(0x08, uid.sak);
+    TEST_ASSERT_EQUAL(Tag::ACTIVE, chip().tag(0).state);
+}
+
+void test_select_7_byte_uid(void) {
+    chip().addTag(Tag::NTAG215, UID7, sizeof(UID7));
+    MFRC522Defs::Uid uid;
+
+    TEST_ASSERT_EQUAL(MFRC522Defs::STATUS_OK, rfid->PICC_DetectAndSelect(&uid));
+    assertUid(UID7, sizeof(UID7), uid);
+    TEST_ASSERT_EQUAL_HEX8(0x00, uid.sak);
+}
+
+void test_select_10_byte_uid(void) {
+    chip().addTag(Tag::ISO_14443_4, UID10, sizeof(UID10));
+    MFRC522Defs::Uid uid;
+
+    TEST_ASSERT_EQUAL(MFRC522Defs::STATUS_OK, rfid->PICC_DetectAndSelect(&uid));
+    assertUid(UID10, sizeof(UID10), uid);
+    TEST_ASSERT_EQUAL_HEX8(0x20, uid.sak);
+}
+
+void test_inventory_resolves_collision_on_first_bit(void) {
+    const byte other[] = {0xDF, 0xAD, 0xBE, 0xEF};  // differe au bit 0
+    chip().addTag(Tag::CLASSIC_1K, UID4, sizeof(UID4));
+    chip().addTag(Tag::CLASSIC_1K, other, sizeof(other));
+    MFRC522Defs::Uid found[4];
+
+    TEST_ASSERT_EQUAL_UINT8(2, rfid->PICC_Inventory(found, 4));
+    assertUid(other, sizeof(other), found[0]);  // le bit 1 gagne
+    assertUid(UID4, sizeof(UID4), found[1]);
+}
+
+void test_inventory_resolves_collision_on_byte_boundary(void) {
+    const byte a[] = {0x04, 0x82, 0x3A, 0x11, 0x22, 0x6C, 0x80};
+    const byte b[] = {0x04, 0x02, 0x3A, 0x11, 0x22, 0x6C, 0x81};  // bit 15 du champ CL1
+    const byte c[] = {0x04, 0x82, 0x3A, 0x12, 0x22, 0x6C, 0x80};  // niveau 2
+    chip().addTag(Tag::NTAG215, a, sizeof(a));
+    chip().addTag(Tag::NTAG215, b, sizeof(b));
+    chip().addTag(Tag::NTAG215, c, sizeof(c));
+    MFRC522Defs::Uid found[4];
+
+    TEST_ASSERT_EQUAL_UINT8(3, rfid->PICC_Inventory(found, 4));
+    for (byte i = 0; i < 3; i++) TEST_ASSERT_EQUAL_UINT8(7, found[i].size);
+}
+
+void test_halted_tag_ignores_reqa_until_wupa(void) {
+    chip().addTag(Tag::NTAG215, UID7, sizeof(UID7));
+    MFRC522Defs::Uid uid;
+    byte atqa[2];
+    byte size = sizeof(atqa);
+
+    TEST_ASSERT_EQUAL(MFRC522Defs::STATUS_OK, rfid->PICC_DetectAndSelect(&uid));
+    TEST_ASSERT_EQUAL(MFRC522Defs::STATUS_OK, rfid->PICC_HaltA());
+    TEST_ASSERT_EQUAL(Tag::HALT, chip().tag(0).state);
+    TEST_ASSERT_EQUAL(MFRC522Defs::STATUS_TIMEOUT, rfid->PICC_RequestA(atqa, &size));
+
+    size = sizeof(atqa);
+    TEST_ASSERT_EQUAL(MFRC522Defs::STATUS_OK, rfid->PICC_WakeupA(atqa, &size));
+    TEST_ASSERT_EQUAL_HEX8(0x44, atqa[0]);
+    TEST_ASSERT_EQUAL(MFRC522Defs::STATUS_OK, rfid->PICC_CheckPresence(&uid));
+}
+
+void test_antenna_off_resets_tags(void) {
+    chip().addTag(Tag::NTAG215, UID7, sizeof(UID7));
+    MFRC522Defs::Uid uid;
+    rfid->PICC_DetectAndSelect(&uid);
+    rfid->PICC_HaltA();
+
+    rfid->PCD_AntennaOff();
+    rfid->PCD_AntennaOn();
+
+    TEST_ASSERT_EQUAL(Tag::IDLE, chip().tag(0).state);
+    TEST_ASSERT_TRUE(rfid->PICC_IsNewCardPresent());
+}
+
+void test_silent_tag_times_out_then_answers(void) {
+    Tag *tag = chip().addTag(Tag::NTAG215, UID7, sizeof(UID7));
+    tag->ignoreFrames = 1;  // REQA perdue
+    MFRC522Defs::Uid uid;
+
+    TEST_ASSERT_EQUAL(MFRC522Defs::STATUS_TIMEOUT, rfid->PICC_DetectAndSelect(&uid));
+    TEST_ASSERT_EQUAL(MFRC522Defs::STATUS_OK, rfid->PICC_DetectAndSelect(&uid));
+    assertUid(UID7, sizeof(UID7), uid);
+}
+
+void test_lost_select_answer_is_retried_with_wupa(void) {
+    Tag *tag = chip().addTag(Tag::NTAG215, UID7, sizeof(UID7));
+    tag->lostSelects = 1;  // le tag obeit au SELECT mais sa reponse se perd
+    MFRC522Defs::Uid uid;
+
+    // Sans relance : REQA, puis SELECT sans reponse
+    TEST_ASSERT_EQUAL(MFRC522Defs::STATUS_TIMEOUT, rfid->PICC_DetectAndSelect(&uid, false, 0));
+    TEST_ASSERT_EQUAL_UINT32(0, chip().stats().wakeups);
+
+    // Avec relance : coupure du champ, puis WUPA et nouvelle selection
+    chip().removeTags();
+    tag = chip().addTag(Tag::NTAG215, UID7, sizeof(UID7));
+    tag->lostSelects = 1;
+    chip().resetStats();
+    TEST_ASSERT_EQUAL(MFRC522Defs::STATUS_OK, rfid->PICC_DetectAndSelect(&uid, false, 1, 2));
+    TEST_ASSERT_EQUAL_UINT32(1, chip().stats().wakeups);
+    TEST_ASSERT_EQUAL(Tag::ACTIVE, tag->state);
+    assertUid(UID7, sizeof(UID7), uid);
+}
+
+// =============================================================================
+// Lecture / ecriture
+// =============================================================================
+
+void test_ultralight_read_and_write(void) {
+    chip().addTag(Tag::NTAG215, UID7, sizeof(UID7));
+    rfid->PICC_DetectAndSelect(&rfid->uid);
+    // WRITE de compatibilite : 16 octets envoyes, la page garde les 4 premiers
+    byte data[16] = {0x10, 0x20, 0x30, 0x40, 0xFF, 0xFF};
+    byte block[18];
+    byte size = sizeof(block);
+
+    TEST_ASSERT_EQUAL(MFRC522Defs::STATUS_OK, rfid->MIFARE_Write(4, data, 16));
+    TEST_ASSERT_EQUAL(MFRC522Defs::STATUS_OK, rfid->MIFARE_Read(4, block, &size));
+    TEST_ASSERT_EQUAL_UINT8(18, size);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(data, block, 4);
+    TEST_ASSERT_EQUAL_HEX8(0x00, block[4]);
+}
+
+void test_ultralight_page_write(void) {
+    Tag *tag = chip().addTag(Tag::NTAG215, UID7, sizeof(UID7));
+    rfid->PICC_DetectAndSelect(&rfid->uid);
+    byte page[4] = {0x52, 0x54, 0x01, 0x42};
+
+    TEST_ASSERT_EQUAL(MFRC522Defs::STATUS_OK, rfid->MIFARE_Ultralight_Write(36, page, 4));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(page, &tag->memory[36 * 4], 4);
+    // Une page = 4 octets exactement
+    TEST_ASSERT_EQUAL(MFRC522Defs::STATUS_INVALID, rfid->MIFARE_Ultralight_Write(37, page, 3));
+}
+
+void test_fast_read_streams_past_the_fifo(void) {
+    Tag *tag = chip().addTag(Tag::NTAG215, UID7, sizeof(UID7));
+    for (uint16_t i = 16; i < tag->memorySize; i++) tag->memory[i] = i & 0xFF;
+    rfid->PICC_DetectAndSelect(&rfid->uid);
+    rfid->MIFARE_SetFastReadChunk(126);
+    byte data[126 * 4 + 2];
+    uint16_t size = sizeof(data);
+
+    TEST_ASSERT_EQUAL(MFRC522Defs::STATUS_OK, rfid->MIFARE_ReadPages(4, 129, data, &size));
+    TEST_ASSERT_EQUAL_UINT16(126 * 4, size);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(&tag->memory[16], data, size);
+}
+
+void test_fast_read_nack_falls_back_to_read(void) {
+    Tag *tag = chip().addTag(Tag::ULTRALIGHT, UID7, sizeof(UID7));
+    for (uint16_t i = 16; i < tag->memorySize; i++) tag->memory[i] = i & 0xFF;
+    rfid->PICC_DetectAndSelect(&rfid->uid);
+    chip().resetStats();
+    byte data[8 * 4 + 2];
+    uint16_t size = sizeof(data);
+
+    // FAST_READ refuse (Ultralight), WUPA + SELECT, puis deux READ de 4 pages
+    TEST_ASSERT_EQUAL(MFRC522Defs::STATUS_OK, rfid->MIFARE_ReadPages(4, 11, data, &size));
+    TEST_ASSERT_EQUAL_UINT16(8 * 4, size);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(&tag->memory[16], data, size);
+    TEST_ASSERT_EQUAL_UINT32(1, chip().stats().wakeups);
+}
+
+void test_nack_tag_falls_back_then_fails(void) {
+    Tag *tag = chip().addTag(Tag::NTAG215, UID7, sizeof(UID7));
+    tag->nackReads = true;
+    rfid->PICC_DetectAndSelect(&rfid->uid);
+    chip().resetStats();
+    byte data[4 * 4 + 2];
+    uint16_t size = sizeof(data);
+
+    // FAST_READ refuse, relance WUPA + SELECT, READ refuse a son tour
+    TEST_ASSERT_EQUAL(MFRC522Defs::STATUS_MIFARE_NACK, rfid->MIFARE_ReadPages(4, 7, data, &size));
+    TEST_ASSERT_EQUAL_UINT32(1, chip().stats().wakeups);
+    TEST_ASSERT_EQUAL(Tag::IDLE, chip().tag(0).state);
+}
+
+void test_classic_needs_authentication(void) {
+    chip().addTag(Tag::CLASSIC_1K, UID4, sizeof(UID4));
+    rfid->PICC_DetectAndSelect(&rfid->uid);
+    MFRC522Defs::MIFARE_Key key;
+    memset(key.keyByte, 0xFF, sizeof(key.keyByte));
+    byte data[16] = {'T', 'C', '0', '1'};
+    byte block[18];
+    byte size = sizeof(block);
+
+    TEST_ASSERT_EQUAL(MFRC522Defs::STATUS_OK,
+                      rfid->PCD_Authenticate(MFRC522Defs::PICC_CMD_MF_AUTH_KEY_A, 4, &key, &rfid->uid));
+    TEST_ASSERT_EQUAL(MFRC522Defs::STATUS_OK, rfid->MIFARE_Write(4, data, 16));
+    TEST_ASSERT_EQUAL(MFRC522Defs::STATUS_OK, rfid->MIFARE_Read(4, block, &size));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(data, block, 16);
+
+    // Autre secteur sans authentification : NAK
+    size = sizeof(block);
+    TEST_ASSERT_EQUAL(MFRC522Defs::STATUS_MIFARE_NACK, rfid->MIFARE_Read(8, block, &size));
+    rfid->PCD_StopCrypto1();
+}
+
+void test_classic_wrong_key_times_out(void) {
+    chip().addTag(Tag::CLASSIC_1K, UID4, sizeof(UID4));
+    rfid->PICC_DetectAndSelect(&rfid->uid);
+    MFRC522Defs::MIFARE_Key key;
+    memset(key.keyByte, 0x00, sizeof(key.keyByte));
+
+    TEST_ASSERT_EQUAL(MFRC522Defs::STATUS_TIMEOUT,
+                      rfid->PCD_Authenticate(MFRC522Defs::PICC_CMD_MF_AUTH_KEY_A, 4, &key, &rfid->uid));
+    TEST_ASSERT_EQUAL(Tag::IDLE, chip().tag(0).state);
+}
+
+void test_read_sectors_one_authentication_each(void) {
+    Tag *tag = chip().addTag(Tag::CLASSIC_1K, UID4, sizeof(UID4));
+    for (uint16_t i = 64; i < 176; i++) {
+        if (i % 64 < 48) tag->memory[i] = i & 0xFF;  // blocs de donnees, pas les trailers
+    }
+    rfid->PICC_DetectAndSelect(&rfid->uid);
+    MFRC522Defs::SectorTiming timings[2];
+    byte data[96];
+    uint16_t size = sizeof(data);
+    chip().resetStats();
+
+    TEST_ASSERT_EQUAL(MFRC522Defs::STATUS_OK, rfid->MIFARE_ReadSectors(1, 2, data, &size, timings));
+    TEST_ASSERT_EQUAL_UINT16(96, size);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(&tag->memory[64], data, 48);    // blocs 4-6
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(&tag->memory[128], &data[48], 48);  // blocs 8-10
+    TEST_ASSERT_EQUAL_UINT32(8, chip().stats().frames);  // 2 x (AUTH + 3 READ)
+    TEST_ASSERT_EQUAL_UINT8(2, timings[1].sector);
+    TEST_ASSERT_EQUAL_UINT8(0, timings[1].keyIndex);
+    TEST_ASSERT_TRUE(timings[0].authUs > 0 && timings[0].readUs > timings[0].authUs);
+}
+
+void test_sector_key_is_cached(void) {
+    MFRC522Defs::MIFARE_Key keys[2];
+    memset(keys[0].keyByte, 0xA0, sizeof(keys[0].keyByte));
+    memset(keys[1].keyByte, 0xFF, sizeof(keys[1].keyByte));
+    rfid->MIFARE_SetKeys(keys, 2);
+    chip().addTag(Tag::CLASSIC_1K, UID4, sizeof(UID4));
+    byte data[48];
+    byte size = sizeof(data);
+
+    // 1er tag : la cle 0 est refusee, le tag est re-selectionne, la cle 1 passe
+    rfid->PICC_DetectAndSelect(&rfid->uid);
+    TEST_ASSERT_EQUAL(MFRC522Defs::STATUS_OK, rfid->MIFARE_ReadSector(1, data, &size));
+    TEST_ASSERT_EQUAL_UINT8(1, rfid->MIFARE_GetSectorKey(1));
+    rfid->PICC_HaltA();
+    rfid->PCD_StopCrypto1();
+
+    // Tag suivant : la cle en cache passe du premier coup
+    chip().removeTags();
+    chip().addTag(Tag::CLASSIC_1K, UID7, sizeof(UID7));
+    rfid->PICC_DetectAndSelect(&rfid->uid);
+    chip().resetStats();
+    size = sizeof(data);
+    TEST_ASSERT_EQUAL(MFRC522Defs::STATUS_OK, rfid->MIFARE_ReadSector(1, data, &size));
+    TEST_ASSERT_EQUAL_UINT32(4, chip().stats().frames);
+
+    rfid->PCD_StopCrypto1();
+    rfid->MIFARE_SetKeys(NULL, 0);
+}
+
+void test_chip_crc_matches_software_crc(void) {
+    // Vecteur connu : HLTA = 50 00 57 CD
+    byte hlta[] = {0x50, 0x00};
+    const byte expected[] = {0x57, 0xCD};
+    byte software[2];
+    byte chipResult[2];
+    rfid->PCD_CalculateCRC(hlta, sizeof(hlta), software);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, software, 2);
+
+    // L'emulateur calcule le CRC_A bit a bit, independamment de MFRC522_CRC
+    byte frame[] = {0x30, 0x04};
+    rfid->PCD_CalculateCRC(frame, sizeof(frame), software);
+    rfid->PCD_SetSoftwareCRC(false);
+    TEST_ASSERT_EQUAL(MFRC522Defs::STATUS_OK, rfid->PCD_CalculateCRC(frame, sizeof(frame), chipResult));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(software, chipResult, 2);
+    TEST_ASSERT_EQUAL(MFRC522Defs::STATUS_OK, rfid->PCD_CalculateCRC(hlta, sizeof(hlta), chipResult));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, chipResult, 2);
+}
+
+void test_self_test_passes(void) {
+    TEST_ASSERT_TRUE(rfid->PCD_PerformSelfTest());
+}
+
+// =============================================================================
+// Cout bus par operation (metrique de regression)
+// =============================================================================
+
+void test_detect_and_select_cost(void) {
+    chip().addTag(Tag::NTAG215, UID7, sizeof(UID7));
+    MFRC522Defs::Uid uid;
+    char message[96];
+
+    TEST_ASSERT_EQUAL(MFRC522Defs::STATUS_OK, rfid->PICC_DetectAndSelect(&uid));
+
+    const MFRC522_Emulator::Stats &stats = chip().stats();
+    snprintf(message, sizeof(message), "select UID 7 : %u transactions, %u octets, bus %u us, air %u us",
+             (unsigned)stats.transactions, (unsigned)stats.bytes, (unsigned)stats.busUs,
+             (unsigned)stats.airUs);
+    TEST_MESSAGE(message);
+    TEST_ASSERT_EQUAL_UINT32(stats.transactions, rfid->PCD_GetBusStats().transactions);
+    TEST_ASSERT_EQUAL_UINT32(5, stats.frames);  // REQA, 2 x (ANTICOLLISION + SELECT)
+    TEST_ASSERT_EQUAL_UINT32(35, stats.transactions);
+}
+
+// =============================================================================
+// Point d'entrée des tests
+// =============================================================================
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+
+    // Selection
+    RUN_TEST(test_empty_field_times_out);
+    RUN_TEST(test_select_4_byte_uid);
+    RUN_TEST(test_select_7_byte_uid);
+    RUN_TEST(test_select_10_byte_uid);
+    RUN_TEST(test_inventory_resolves_collision_on_first_bit);
+    RUN_TEST(test_inventory_resolves_collision_on_byte_boundary);
+    RUN_TEST(test_halted_tag_ignores_reqa_until_wupa);
+    RUN_TEST(test_antenna_off_resets_tags);
+    RUN_TEST(test_silent_tag_times_out_then_answers);
+    RUN_TEST(test_lost_select_answer_is_retried_with_wupa);
+
+    // Lecture / ecriture
+    RUN_TEST(test_ultralight_read_and_write);
+    RUN_TEST(test_ultralight_page_write);
+    RUN_TEST(test_fast_read_streams_past_the_fifo);
+    RUN_TEST(test_fast_read_nack_falls_back_to_read);
+    RUN_TEST(test_nack_tag_falls_back_then_fails);
+    RUN_TEST(test_classic_needs_authentication);
+    RUN_TEST(test_classic_wrong_key_times_out);
+    RUN_TEST(test_read_sectors_one_authentication_each);
+    RUN_TEST(test_sector_key_is_cached);
+    RUN_TEST(test_chip_crc_matches_software_crc);
+    RUN_TEST(test_self_test_passes);
+
+    // Cout bus
+    RUN_TEST(test_detect_and_select_cost);
+
+    return UNITY_END();
+}
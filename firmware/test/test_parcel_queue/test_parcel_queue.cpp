@@ -0,0 +1,212 @@
+/**
+ * =============================================================================
+ * Test Unitaire - File des colis en vol (ParcelQueue)
+ * =============================================================================
+ * Projet : The Conveyor (T-IOT-901)
+ * Fichier : test/test_parcel_queue/test_parcel_queue.cpp
+ *
+ * Verifie la file circulaire des colis routes entre lecteur et aiguillage :
+ * ordre d'arrivee (les colis ne se doublent pas sur le tapis), capacite
+ * fixe, rebouclage de l'anneau et maximum de colis en vol ; puis les
+ * commandes d'aiguillage selon la position tapis (servo, sortie, retard).
+ * Executer avec : pio test -e native
+ * =============================================================================
+ */
+
+#include <unity.h>
+#include "ParcelQueue.h"
+
+// Lecture -> servo commande, lecture -> colis sorti, course pendant le servo
+static const float SWITCH_MM = 60;
+static const float EXIT_MM = 120;
+static const float SETTLE_MM = 25;
+
+static ParcelQueue<4> queue(SWITCH_MM, EXIT_MM, SETTLE_MM);
+
+static Parcel parcelAt(float readMm, uint8_t warehouse) {
+    const uint8_t uid[] = {0x04, 0x10, 0x20, (uint8_t)readMm};
+    Parcel parcel;
+    parcel.uid = TagUid(uid, sizeof(uid));
+    parcel.warehouse = warehouse;
+    parcel.store = 'A' + warehouse - 1;
+    parcel.readMm = readMm;
+    return parcel;
+}
+
+void setUp(void) {
+    queue = ParcelQueue<4>(SWITCH_MM, EXIT_MM, SETTLE_MM);
+}
+
+void tearDown(void) {
+}
+
+// =============================================================================
+// Ordre et capacite
+// =============================================================================
+
+void test_parcels_leave_in_read_order(void) {
+    queue.push(parcelAt(10, 1));
+    queue.push(parcelAt(40, 3));
+    queue.push(parcelAt(75, 2));
+
+    TEST_ASSERT_EQUAL_UINT8(3, queue.size());
+    TEST_ASSERT_EQUAL_UINT8(1, queue.front().warehouse);
+    TEST_ASSERT_EQUAL_UINT8(3, queue.at(1).warehouse);
+    queue.pop();
+    TEST_ASSERT_EQUAL_UINT8(3, queue.front().warehouse);
+    queue.pop();
+    TEST_ASSERT_EQUAL_UINT8(2, queue.front().warehouse);
+    TEST_ASSERT_EQUAL('B', queue.front().store);
+}
+
+void test_full_queue_refuses_parcel(void) {
+    for (int i = 0; i < 4; i++) TEST_ASSERT_TRUE(queue.push(parcelAt(i * 30, 1)));
+
+    TEST_ASSERT_TRUE(queue.full());
+    TEST_ASSERT_FALSE(queue.push(parcelAt(200, 2)));
+    TEST_ASSERT_EQUAL_UINT8(4, queue.size());
+}
+
+void test_ring_wraps_around(void) {
+    // 10 colis, jamais plus de 3 en vol : l'anneau reboucle plusieurs fois
+    float next = 0;
+    for (int i = 0; i < 10; i++) {
+        if (queue.size() == 3) queue.pop();
+        queue.push(parcelAt(next, 1 + i % 3));
+        next += 25;
+    }
+
+    TEST_ASSERT_EQUAL_UINT8(3, queue.size());
+    TEST_ASSERT_EQUAL_FLOAT(175.0f, queue.front().readMm);
+    TEST_ASSERT_EQUAL_FLOAT(225.0f, queue.at(2).readMm);
+    TEST_ASSERT_EQUAL_UINT8(3, queue.maxSize());
+}
+
+void test_switched_flag_is_kept_per_parcel(void) {
+    queue.push(parcelAt(10, 1));
+    queue.push(parcelAt(40, 2));
+    queue.front().switched = true;
+
+    TEST_ASSERT_FALSE(queue.at(1).switched);
+    queue.pop();
+    TEST_ASSERT_FALSE(queue.front().switched);
+}
+
+void test_pop_and_clear_on_empty_queue(void) {
+    queue.pop();
+    TEST_ASSERT_TRUE(queue.empty());
+
+    queue.push(parcelAt(10, 1));
+    queue.clear();
+    TEST_ASSERT_TRUE(queue.empty());
+    TEST_ASSERT_FALSE(queue.full());
+}
+
+// =============================================================================
+// Aiguillage (service)
+// =============================================================================
+
+void test_servo_switches_at_offset(void) {
+    queue.push(parcelAt(10, 3));
+
+    TEST_ASSERT_EQUAL(DiverterStep::NONE, queue.service(69).action);
+    DiverterStep step = queue.service(70);
+    TEST_ASSERT_EQUAL(DiverterStep::SWITCH, step.action);
+    TEST_ASSERT_EQUAL_UINT8(3, step.parcel.warehouse);
+    TEST_ASSERT_FALSE(step.late);
+    // Une seule commande servo par colis
+    TEST_ASSERT_EQUAL(DiverterStep::NONE, queue.service(71).action);
+}
+
+void test_parcel_exits_at_diverter(void) {
+    queue.push(parcelAt(10, 1));
+    queue.service(70);
+
+    TEST_ASSERT_EQUAL(DiverterStep::NONE, queue.service(129).action);
+    DiverterStep step = queue.service(130);
+    TEST_ASSERT_EQUAL(DiverterStep::EXIT, step.action);
+    TEST_ASSERT_EQUAL_FLOAT(10.0f, step.parcel.readMm);
+    TEST_ASSERT_FALSE(step.late);
+    TEST_ASSERT_TRUE(queue.empty());
+    TEST_ASSERT_EQUAL(DiverterStep::NONE, queue.service(200).action);
+}
+
+void test_spaced_parcels_switch_in_time(void) {
+    queue.push(parcelAt(0, 1));
+    TEST_ASSERT_FALSE(queue.wouldBeLate(40));
+    queue.push(parcelAt(40, 2));
+
+    TEST_ASSERT_EQUAL(DiverterStep::SWITCH, queue.service(60).action);
+    TEST_ASSERT_EQUAL(DiverterStep::NONE, queue.service(110).action);
+    TEST_ASSERT_EQUAL(DiverterStep::EXIT, queue.service(120).action);
+    DiverterStep step = queue.service(120);
+    TEST_ASSERT_EQUAL(DiverterStep::SWITCH, step.action);
+    TEST_ASSERT_EQUAL_UINT8(2, step.parcel.warehouse);
+    TEST_ASSERT_FALSE(step.late);
+}
+
+void test_back_to_back_parcels_switch_late(void) {
+    queue.push(parcelAt(0, 1));
+    // 20 mm derriere : le servo ne se libere qu'a 100 mm de sa lecture
+    TEST_ASSERT_TRUE(queue.wouldBeLate(20));
+    queue.push(parcelAt(20, 3));
+
+    TEST_ASSERT_EQUAL(DiverterStep::SWITCH, queue.service(60).action);
+    // Le 2e colis a passe son point de commande, le servo sert encore le 1er
+    TEST_ASSERT_EQUAL(DiverterStep::NONE, queue.service(100).action);
+    TEST_ASSERT_EQUAL(DiverterStep::EXIT, queue.service(120).action);
+    DiverterStep step = queue.service(120);
+    TEST_ASSERT_EQUAL(DiverterStep::SWITCH, step.action);
+    TEST_ASSERT_EQUAL_UINT8(3, step.parcel.warehouse);
+    TEST_ASSERT_TRUE(step.late);
+}
+
+void test_stopped_belt_holds_parcels(void) {
+    queue.push(parcelAt(0, 2));
+    queue.service(70);
+
+    // Tapis arrete : meme position a chaque tour, le colis attend sur place
+    for (int i = 0; i < 100; i++) {
+        TEST_ASSERT_EQUAL(DiverterStep::NONE, queue.service(70).action);
+    }
+    TEST_ASSERT_EQUAL_UINT8(1, queue.size());
+    TEST_ASSERT_TRUE(queue.front().switched);
+}
+
+void test_position_jump_exits_unswitched(void) {
+    queue.push(parcelAt(0, 1));
+    queue.push(parcelAt(50, 2));
+
+    // Saut de position : les deux colis sont deja sortis, sans servo
+    DiverterStep step = queue.service(500);
+    TEST_ASSERT_EQUAL(DiverterStep::EXIT, step.action);
+    TEST_ASSERT_TRUE(step.late);
+    TEST_ASSERT_EQUAL(DiverterStep::EXIT, queue.service(500).action);
+    TEST_ASSERT_EQUAL(DiverterStep::NONE, queue.service(500).action);
+    TEST_ASSERT_TRUE(queue.empty());
+}
+
+// =============================================================================
+// Point d'entrée des tests
+// =============================================================================
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+
+    // Ordre et capacite
+    RUN_TEST(test_parcels_leave_in_read_order);
+    RUN_TEST(test_full_queue_refuses_parcel);
+    RUN_TEST(test_ring_wraps_around);
+    RUN_TEST(test_switched_flag_is_kept_per_parcel);
+    RUN_TEST(test_pop_and_clear_on_empty_queue);
+
+    // Aiguillage
+    RUN_TEST(test_servo_switches_at_offset);
+    RUN_TEST(test_parcel_exits_at_diverter);
+    RUN_TEST(test_spaced_parcels_switch_in_time);
+    RUN_TEST(test_back_to_back_parcels_switch_late);
+    RUN_TEST(test_stopped_belt_holds_parcels);
+    RUN_TEST(test_position_jump_exits_unswitched);
+
+    return UNITY_END();
+}
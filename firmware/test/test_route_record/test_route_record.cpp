@@ -0,0 +1,179 @@
+/**
+ * =============================================================================
+ * Test Unitaire - Enregistrement d'aiguillage sur le tag (RouteRecord)
+ * =============================================================================
+ * Projet : The Conveyor (T-IOT-901)
+ * Fichier : test/test_route_record/test_route_record.cpp
+ *
+ * Verifie le codec du bloc de 16 octets ecrit sur le tag par une station et
+ * relu par la suivante pour router sans appel API : aller-retour, format
+ * fixe, et rejet (=> repli sur l'API) d'un bloc vierge, d'une autre version,
+ * d'un octet corrompu ou d'un bloc recopie sur un autre tag ; pages de
+ * l'enregistrement selon le type Ultralight / NTAG.
+ * Executer avec : pio test -e native
+ * =============================================================================
+ */
+
+#include <unity.h>
+#include <string.h>
+#include "MFRC522_CRC.h"
+#include "RouteRecord.h"
+
+static const uint8_t UID7[] = {0x04, 0x82, 0x3A, 0x11, 0x22, 0x6C, 0x80};
+static const uint8_t UID4[] = {0xDE, 0xAD, 0xBE, 0xEF};
+
+static RouteRecord sample() {
+    RouteRecord record;
+    record.store = 'C';
+    record.warehouse = 3;
+    record.station = 2;
+    record.writes = 5;
+    record.timestamp = 1760000000u;
+    return record;
+}
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+// =============================================================================
+// Aller-retour et format
+// =============================================================================
+
+void test_record_round_trip(void) {
+    TagUid uid(UID7, sizeof(UID7));
+    uint8_t block[RouteRecord::SIZE];
+    sample().encode(block, uid);
+
+    RouteRecord decoded;
+    TEST_ASSERT_TRUE(decoded.decode(block, uid));
+    TEST_ASSERT_TRUE(decoded.valid());
+    TEST_ASSERT_EQUAL('C', decoded.store);
+    TEST_ASSERT_EQUAL_UINT8(3, decoded.warehouse);
+    TEST_ASSERT_EQUAL_UINT8(2, decoded.station);
+    TEST_ASSERT_EQUAL_UINT8(5, decoded.writes);
+    TEST_ASSERT_EQUAL_UINT32(1760000000u, decoded.timestamp);
+}
+
+void test_record_layout(void) {
+    // Format fige : lu par d'autres stations (et d'autres versions du firmware)
+    TagUid uid(UID4, sizeof(UID4));
+    uint8_t block[RouteRecord::SIZE];
+    sample().encode(block, uid);
+
+    const uint8_t head[] = {'R', 'T', RouteRecord::VERSION, 'C', 3, 2, 5, 0,
+                            0x00, 0x78, 0xE7, 0x68, 0, 0};
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(head, block, sizeof(head));
+
+    uint16_t crc = MFRC522_CRC::update(MFRC522_CRC::compute(block, 14), UID4, sizeof(UID4));
+    TEST_ASSERT_EQUAL_HEX8(crc & 0xFF, block[14]);
+    TEST_ASSERT_EQUAL_HEX8(crc >> 8, block[15]);
+}
+
+// =============================================================================
+// Rejets (=> appel API)
+// =============================================================================
+
+void test_blank_block_is_rejected(void) {
+    TagUid uid(UID7, sizeof(UID7));
+    uint8_t blank[RouteRecord::SIZE];
+    RouteRecord decoded = sample();
+
+    memset(blank, 0x00, sizeof(blank));
+    TEST_ASSERT_FALSE(decoded.decode(blank, uid));
+    TEST_ASSERT_FALSE(decoded.valid());
+
+    memset(blank, 0xFF, sizeof(blank));
+    TEST_ASSERT_FALSE(decoded.decode(blank, uid));
+}
+
+void test_other_version_is_rejected(void) {
+    TagUid uid(UID7, sizeof(UID7));
+    uint8_t block[RouteRecord::SIZE];
+    sample().encode(block, uid);
+    block[2] = RouteRecord::VERSION + 1;
+
+    RouteRecord decoded;
+    TEST_ASSERT_FALSE(decoded.decode(block, uid));
+}
+
+void test_every_corrupted_byte_is_rejected(void) {
+    TagUid uid(UID7, sizeof(UID7));
+    uint8_t block[RouteRecord::SIZE];
+    sample().encode(block, uid);
+
+    for (uint8_t i = 0; i < RouteRecord::SIZE; i++) {
+        uint8_t corrupted[RouteRecord::SIZE];
+        memcpy(corrupted, block, sizeof(block));
+        corrupted[i] ^= 0x01;
+        RouteRecord decoded;
+        TEST_ASSERT_FALSE(decoded.decode(corrupted, uid));
+        TEST_ASSERT_FALSE(decoded.valid());
+    }
+}
+
+void test_record_copied_to_another_tag_is_rejected(void) {
+    TagUid written(UID7, sizeof(UID7));
+    TagUid other(UID4, sizeof(UID4));
+    uint8_t block[RouteRecord::SIZE];
+    sample().encode(block, written);
+
+    RouteRecord decoded;
+    TEST_ASSERT_FALSE(decoded.decode(block, other));
+}
+
+void test_unrouted_record_is_rejected(void) {
+    // Entrepot 0 = pas de decision, meme avec un CRC correct
+    TagUid uid(UID7, sizeof(UID7));
+    RouteRecord record = sample();
+    record.warehouse = 0;
+    uint8_t block[RouteRecord::SIZE];
+    record.encode(block, uid);
+
+    RouteRecord decoded;
+    TEST_ASSERT_FALSE(decoded.decode(block, uid));
+}
+
+// =============================================================================
+// Emplacement Ultralight / NTAG
+// =============================================================================
+
+void test_ultralight_page_is_end_of_user_memory(void) {
+    // Octet 2 du Capability Container = zone de donnees / 8
+    TEST_ASSERT_EQUAL_UINT8(36, RouteRecord::ultralightPage(0x12));   // NTAG213 : 4-39
+    TEST_ASSERT_EQUAL_UINT8(126, RouteRecord::ultralightPage(0x3E));  // NTAG215 : 4-129
+    TEST_ASSERT_EQUAL_UINT8(222, RouteRecord::ultralightPage(0x6D));  // NTAG216 : 4-225
+    TEST_ASSERT_EQUAL_UINT8(12, RouteRecord::ultralightPage(0x06));   // Ultralight : 4-15
+}
+
+void test_unknown_ultralight_layout_has_no_page(void) {
+    TEST_ASSERT_EQUAL_UINT8(0, RouteRecord::ultralightPage(0x00));  // CC vierge
+    TEST_ASSERT_EQUAL_UINT8(0, RouteRecord::ultralightPage(0xFE));
+}
+
+// =============================================================================
+// Point d'entrée des tests
+// =============================================================================
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+
+    // Aller-retour
+    RUN_TEST(test_record_round_trip);
+    RUN_TEST(test_record_layout);
+
+    // Rejets
+    RUN_TEST(test_blank_block_is_rejected);
+    RUN_TEST(test_other_version_is_rejected);
+    RUN_TEST(test_every_corrupted_byte_is_rejected);
+    RUN_TEST(test_record_copied_to_another_tag_is_rejected);
+    RUN_TEST(test_unrouted_record_is_rejected);
+
+    // Emplacement Ultralight / NTAG
+    RUN_TEST(test_ultralight_page_is_end_of_user_memory);
+    RUN_TEST(test_unknown_ultralight_layout_has_no_page);
+
+    return UNITY_END();
+}
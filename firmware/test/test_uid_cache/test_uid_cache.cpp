@@ -0,0 +1,225 @@
+/**
+ * =============================================================================
+ * Test Unitaire - UID tag (TagUid) et cache des UID deja lus (UidCache)
+ * =============================================================================
+ * Projet : The Conveyor (T-IOT-901)
+ * Fichier : test/test_uid_cache/test_uid_cache.cpp
+ *
+ * Verifie la valeur TagUid (hexa avec / sans separateur pour 4, 7 et 10
+ * octets, taille de tampon, UID vide, egalite entre tailles) et le filtre
+ * anti-doublons de la lecture RFID : doublon dans le TTL,
+ * expiration, horodatage rafraichi par un doublon, sondage lineaire au-dela
+ * d'une case expiree, remplacement de la plus ancienne entree quand la table
+ * est pleine et passage de millis() par zero.
+ * Executer avec : pio test -e native
+ * =============================================================================
+ */
+
+#include <unity.h>
+#include "UidCache.h"
+
+static const uint32_t TTL_MS = 1000;
+static UidCache<4> cache(TTL_MS);
+
+// UID 7 octets dont le hachage tombe dans la case `bucket` (meme case de
+// depart pour le sondage lineaire), le n-ieme trouve
+static TagUid uidInBucket(uint8_t bucket, uint8_t n = 0) {
+    uint8_t bytes[] = {0x04, 0x82, 0x3A, 0x11, 0x52, 0x6C, 0x00};
+    for (uint16_t last = 0; last < 256; last++) {
+        bytes[6] = (uint8_t)last;
+        TagUid uid(bytes, sizeof(bytes));
+        if (uid.hash() % 4 == bucket && n-- == 0) return uid;
+    }
+    return TagUid();
+}
+
+void setUp(void) {
+    cache = UidCache<4>(TTL_MS);
+}
+
+void tearDown(void) {
+}
+
+// =============================================================================
+// TagUid
+// =============================================================================
+
+static const uint8_t UID4[] = {0xDE, 0xAD, 0xBE, 0xEF};
+static const uint8_t UID7[] = {0x04, 0x82, 0x3A, 0x11, 0x52, 0x6C, 0x80};
+static const uint8_t UID10[] = {0x08, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x0F};
+
+void test_hex_without_separator(void) {
+    char hex[TagUid::HEX_BUFFER_SIZE];
+
+    TEST_ASSERT_EQUAL_UINT32(8, TagUid(UID4, sizeof(UID4)).toHex(hex, sizeof(hex)));
+    TEST_ASSERT_EQUAL_STRING("DEADBEEF", hex);
+    TEST_ASSERT_EQUAL_UINT32(14, TagUid(UID7, sizeof(UID7)).toHex(hex, sizeof(hex)));
+    TEST_ASSERT_EQUAL_STRING("04823A11526C80", hex);
+    TEST_ASSERT_EQUAL_UINT32(20, TagUid(UID10, sizeof(UID10)).toHex(hex, sizeof(hex)));
+    TEST_ASSERT_EQUAL_STRING("0801020304050607080F", hex);
+}
+
+void test_hex_with_separator(void) {
+    char hex[TagUid::HEX_BUFFER_SIZE];
+
+    TEST_ASSERT_EQUAL_UINT32(11, TagUid(UID4, sizeof(UID4)).toHex(hex, sizeof(hex), ':'));
+    TEST_ASSERT_EQUAL_STRING("DE:AD:BE:EF", hex);
+    TEST_ASSERT_EQUAL_UINT32(20, TagUid(UID7, sizeof(UID7)).toHex(hex, sizeof(hex), ':'));
+    TEST_ASSERT_EQUAL_STRING("04:82:3A:11:52:6C:80", hex);
+}
+
+void test_hex_buffer_size_fits_10_bytes_with_separator(void) {
+    TagUid uid(UID10, sizeof(UID10));
+    char hex[TagUid::HEX_BUFFER_SIZE + 1];
+    memset(hex, '#', sizeof(hex));
+
+    TEST_ASSERT_EQUAL_UINT32(29, uid.toHex(hex, TagUid::HEX_BUFFER_SIZE, ':'));
+    TEST_ASSERT_EQUAL_STRING("08:01:02:03:04:05:06:07:08:0F", hex);
+    TEST_ASSERT_EQUAL('#', hex[TagUid::HEX_BUFFER_SIZE]);  // Rien au-dela
+}
+
+void test_hex_buffer_too_small(void) {
+    TagUid uid(UID10, sizeof(UID10));
+    char hex[TagUid::HEX_BUFFER_SIZE];
+    hex[0] = '#';
+
+    TEST_ASSERT_EQUAL_UINT32(0, uid.toHex(hex, TagUid::HEX_BUFFER_SIZE - 1, ':'));
+    TEST_ASSERT_EQUAL_UINT32(0, uid.toHex(hex, 20));  // 20 chiffres + NUL
+    TEST_ASSERT_EQUAL('#', hex[0]);
+}
+
+void test_empty_uid(void) {
+    TagUid uid;
+    char hex[4] = "###";
+
+    TEST_ASSERT_TRUE(uid.empty());
+    TEST_ASSERT_EQUAL_UINT32(0, uid.toHex(hex, sizeof(hex), ':'));
+    TEST_ASSERT_EQUAL_STRING("", hex);
+    TEST_ASSERT_TRUE(uid == TagUid());
+
+    TagUid read(UID4, sizeof(UID4));
+    read.clear();
+    TEST_ASSERT_TRUE(read.empty());
+}
+
+void test_equality_across_sizes(void) {
+    // Memes premiers octets, completes par des zeros : tailles differentes
+    const uint8_t padded[] = {0xDE, 0xAD, 0xBE, 0xEF, 0x00, 0x00, 0x00};
+    TagUid short4(UID4, sizeof(UID4));
+    TagUid long7(padded, sizeof(padded));
+
+    TEST_ASSERT_TRUE(short4 != long7);
+    TEST_ASSERT_TRUE(short4 == TagUid(UID4, sizeof(UID4)));
+    TEST_ASSERT_EQUAL_UINT32(TagUid(UID4, sizeof(UID4)).hash(), short4.hash());
+    TEST_ASSERT_NOT_EQUAL(short4.hash(), long7.hash());
+}
+
+// =============================================================================
+// TTL
+// =============================================================================
+
+void test_duplicate_within_ttl_is_a_hit(void) {
+    TagUid uid = uidInBucket(0);
+
+    TEST_ASSERT_FALSE(cache.checkAndInsert(uid, 1000));
+    TEST_ASSERT_TRUE(cache.checkAndInsert(uid, 1500));
+    TEST_ASSERT_EQUAL_UINT32(1, cache.hits());
+    TEST_ASSERT_EQUAL_UINT32(1, cache.misses());
+}
+
+void test_entry_expires_after_ttl(void) {
+    TagUid uid = uidInBucket(0);
+
+    cache.checkAndInsert(uid, 1000);
+    TEST_ASSERT_FALSE(cache.checkAndInsert(uid, 1000 + TTL_MS));
+    TEST_ASSERT_EQUAL_UINT32(2, cache.misses());
+}
+
+void test_hit_refreshes_timestamp(void) {
+    // Colis arrete devant le lecteur : relu en continu, jamais re-route
+    TagUid uid = uidInBucket(1);
+
+    cache.checkAndInsert(uid, 0);
+    TEST_ASSERT_TRUE(cache.checkAndInsert(uid, 800));
+    TEST_ASSERT_TRUE(cache.checkAndInsert(uid, 1600));
+    TEST_ASSERT_TRUE(cache.checkAndInsert(uid, 2400));
+}
+
+// =============================================================================
+// Sondage et remplacement
+// =============================================================================
+
+void test_probe_continues_past_expired_slot(void) {
+    TagUid first = uidInBucket(2, 0);
+    TagUid second = uidInBucket(2, 1);
+
+    cache.checkAndInsert(first, 0);     // Case 2
+    cache.checkAndInsert(second, 600);  // Collision : case 3
+    // first expire, second encore vivant derriere lui
+    TEST_ASSERT_TRUE(cache.checkAndInsert(second, 1200));
+    TEST_ASSERT_FALSE(cache.checkAndInsert(first, 1200));
+}
+
+void test_colliding_insert_keeps_live_entries(void) {
+    TagUid first = uidInBucket(3, 0);
+    TagUid second = uidInBucket(3, 1);
+    TagUid third = uidInBucket(3, 2);
+
+    cache.checkAndInsert(first, 0);
+    cache.checkAndInsert(second, 600);
+    cache.checkAndInsert(third, 1200);  // Case expiree de first reprise
+
+    TEST_ASSERT_TRUE(cache.checkAndInsert(second, 1300));
+    TEST_ASSERT_TRUE(cache.checkAndInsert(third, 1300));
+}
+
+void test_full_table_evicts_oldest(void) {
+    TagUid uids[5];
+    for (uint8_t i = 0; i < 5; i++) uids[i] = uidInBucket(i % 4, i / 4);
+    for (uint8_t i = 0; i < 4; i++) cache.checkAndInsert(uids[i], i * 10);
+
+    // Table pleine, tout vivant : uids[0] (t = 0) remplace
+    TEST_ASSERT_FALSE(cache.checkAndInsert(uids[4], 40));
+    TEST_ASSERT_TRUE(cache.checkAndInsert(uids[3], 50));
+    TEST_ASSERT_TRUE(cache.checkAndInsert(uids[4], 50));
+    TEST_ASSERT_FALSE(cache.checkAndInsert(uids[0], 60));  // Remplace uids[1]
+    TEST_ASSERT_TRUE(cache.checkAndInsert(uids[2], 70));
+    TEST_ASSERT_FALSE(cache.checkAndInsert(uids[1], 80));
+}
+
+void test_millis_wrap_around(void) {
+    TagUid uid = uidInBucket(0);
+
+    cache.checkAndInsert(uid, 0xFFFFFF00u);
+    TEST_ASSERT_TRUE(cache.checkAndInsert(uid, 0x00000050u));   // 336 ms plus tard
+    TEST_ASSERT_FALSE(cache.checkAndInsert(uid, 0x00000050u + TTL_MS));
+}
+
+// =============================================================================
+// Point d'entrée des tests
+// =============================================================================
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+
+    // TagUid
+    RUN_TEST(test_hex_without_separator);
+    RUN_TEST(test_hex_with_separator);
+    RUN_TEST(test_hex_buffer_size_fits_10_bytes_with_separator);
+    RUN_TEST(test_hex_buffer_too_small);
+    RUN_TEST(test_empty_uid);
+    RUN_TEST(test_equality_across_sizes);
+
+    // TTL
+    RUN_TEST(test_duplicate_within_ttl_is_a_hit);
+    RUN_TEST(test_entry_expires_after_ttl);
+    RUN_TEST(test_hit_refreshes_timestamp);
+
+    // Sondage et remplacement
+    RUN_TEST(test_probe_continues_past_expired_slot);
+    RUN_TEST(test_colliding_insert_keeps_live_entries);
+    RUN_TEST(test_full_table_evicts_oldest);
+    RUN_TEST(test_millis_wrap_around);
+
+    return UNITY_END();
+}
@@ -1,6 +1,6 @@
 /*
  * M5Stack RFID 2 Unit Test
- * Using official M5Stack MFRC522 I2C library
+ * Driver: firmware/lib/MFRC522 (meme code que le firmware)
  */
 
 #include <M5Stack.h>
@@ -0,0 +1,235 @@
+/*
+ * M5Stack RFID 2 Unit - Banc de mesure
+ * Driver: firmware/lib/MFRC522 (meme code que le firmware)
+ *
+ * Bouton A : inventaire multi-tags (PICC_Inventory), tags/seconde
+ * Bouton B : lecture zone utilisateur NTAG215, READ vs FAST_READ
+ * Bouton C : tag ISO 14443-4, echanges I-block a 106 kbps vs debit negocie
+ *
+ * Poser 1 a 5 tags dans le champ puis appuyer sur A.
+ */
+
+#include <M5Stack.h>
+#include <Wire.h>
+#include "MFRC522_I2C.h"
+
+#define RFID_I2C_ADDR       0x28
+#define BENCH_PASSES        50
+#define INVENTORY_MAX_TAGS  8
+#define NTAG_FIRST_PAGE     4       // Zone utilisateur NTAG215 : pages 4..129
+#define NTAG_LAST_PAGE      129
+#define BITRATE_EXCHANGES   20
+
+MFRC522 mfrc522(RFID_I2C_ADDR);
+
+void printUid(const MFRC522::Uid& uid) {
+    for (byte i = 0; i < uid.size; i++) {
+        Serial.printf("%02X", uid.uidByte[i]);
+        if (i < uid.size - 1) Serial.print(":");
+    }
+}
+
+void displayResult(const char* title, const char* line1, const char* line2) {
+    M5.Lcd.fillRect(0, 100, 320, 140, BLACK);
+    M5.Lcd.setCursor(10, 110);
+    M5.Lcd.setTextColor(CYAN);
+    M5.Lcd.println(title);
+    M5.Lcd.setTextColor(WHITE);
+    M5.Lcd.println(line1);
+    M5.Lcd.println(line2);
+}
+
+// Inventaire repete : chaque passe selectionne + halte tous les tags du champ.
+// Les tags sont reveilles (WUPA) entre deux passes pour repartir de zero.
+void benchInventory() {
+    MFRC522::Uid tags[INVENTORY_MAX_TAGS];
+    unsigned long totalUs = 0;
+    unsigned long totalTags = 0;
+    unsigned long totalTransactions = 0;
+    byte minFound = 0xFF;
+    byte maxFound = 0;
+
+    Serial.println("\n--- Bench inventaire ---");
+    for (int pass = 0; pass < BENCH_PASSES; pass++) {
+        // Ramener les tags haltes en IDLE : coupure du champ
+        mfrc522.PCD_AntennaOff();
+        delay(5);
+        mfrc522.PCD_AntennaOn();
+        delay(5);
+
+        mfrc522.PCD_ResetBusStats();
+        unsigned long start = micros();
+        byte found = mfrc522.PICC_Inventory(tags, INVENTORY_MAX_TAGS);
+        unsigned long elapsed = micros() - start;
+
+        totalUs += elapsed;
+        totalTags += found;
+        totalTransactions += mfrc522.PCD_GetBusStats().transactions;
+        if (found < minFound) minFound = found;
+        if (found > maxFound) maxFound = found;
+
+        if (pass == 0) {
+            for (byte i = 0; i < found; i++) {
+                Serial.print("  Tag ");
+                Serial.print(i + 1);
+                Serial.print(": ");
+                printUid(tags[i]);
+                Serial.println();
+            }
+        }
+    }
+
+    float seconds = totalUs / 1e6f;
+    float tagsPerSecond = seconds > 0 ? totalTags / seconds : 0;
+    Serial.printf("Passes: %d, tags/passe: %u..%u\n", BENCH_PASSES, minFound, maxFound);
+    Serial.printf("Temps moyen/passe: %lu us\n", totalUs / BENCH_PASSES);
+    Serial.printf("Transactions I2C/passe: %lu\n", totalTransactions / BENCH_PASSES);
+    Serial.printf("Debit: %.1f tags/s\n", tagsPerSecond);
+
+    char line1[32];
+    char line2[32];
+    snprintf(line1, sizeof(line1), "Tags: %u..%u", minFound, maxFound);
+    snprintf(line2, sizeof(line2), "%.1f tags/s", tagsPerSecond);
+    displayResult("Inventaire", line1, line2);
+}
+
+bool selectTag() {
+    byte status = mfrc522.PICC_DetectAndSelect(&mfrc522.uid, true);
+    if (status != MFRC522::STATUS_OK) {
+        Serial.print("Selection: ");
+        Serial.println(mfrc522.GetStatusCodeName(status));
+        return false;
+    }
+    return true;
+}
+
+// Lecture de toute la zone utilisateur : READ (4 pages/trame) puis FAST_READ
+void benchPageRead() {
+    static byte data[(NTAG_LAST_PAGE - NTAG_FIRST_PAGE + 1) * 4 + 2];
+
+    Serial.println("\n--- Bench lecture NTAG ---");
+    if (!selectTag()) return;
+
+    // 1. READ classique, 16 octets par transceive
+    mfrc522.PCD_ResetBusStats();
+    unsigned long start = micros();
+    byte status = MFRC522::STATUS_OK;
+    for (int page = NTAG_FIRST_PAGE; page <= NTAG_LAST_PAGE && status == MFRC522::STATUS_OK; page += 4) {
+        byte block[18];
+        byte blockSize = sizeof(block);
+        status = mfrc522.MIFARE_Read(page, block, &blockSize);
+    }
+    unsigned long readUs = micros() - start;
+    unsigned long readTx = mfrc522.PCD_GetBusStats().transactions;
+    Serial.print("READ      : ");
+    Serial.println(mfrc522.GetStatusCodeName(status));
+    Serial.printf("  %lu us, %lu transactions\n", readUs, readTx);
+
+    // 2. FAST_READ (choix automatique selon le type de tag)
+    mfrc522.PCD_ResetBusStats();
+    start = micros();
+    uint16_t size = sizeof(data);
+    status = mfrc522.MIFARE_ReadPages(NTAG_FIRST_PAGE, NTAG_LAST_PAGE, data, &size);
+    unsigned long fastUs = micros() - start;
+    unsigned long fastTx = mfrc522.PCD_GetBusStats().transactions;
+    Serial.print("FAST_READ : ");
+    Serial.println(mfrc522.GetStatusCodeName(status));
+    Serial.printf("  %u octets, %lu us, %lu transactions\n", size, fastUs, fastTx);
+
+    mfrc522.PICC_HaltA();
+
+    char line1[32];
+    char line2[32];
+    snprintf(line1, sizeof(line1), "READ: %lu ms", readUs / 1000);
+    snprintf(line2, sizeof(line2), "FAST: %lu ms", fastUs / 1000);
+    displayResult("Lecture NTAG", line1, line2);
+}
+
+// Envoie BITRATE_EXCHANGES I-blocks (SELECT FILE MF) et renvoie la duree en us.
+// Tout statut ISO 7816 convient : seul le temps d'echange est mesure.
+unsigned long timeIBlocks() {
+    static const byte apdu[] = {0x00, 0xA4, 0x00, 0x0C, 0x02, 0x3F, 0x00};
+    byte pcb = 0x02;
+    unsigned long start = micros();
+    for (int i = 0; i < BITRATE_EXCHANGES; i++) {
+        byte frame[MFRC522::FIFO_SIZE];
+        frame[0] = pcb;
+        memcpy(&frame[1], apdu, sizeof(apdu));
+        mfrc522.PCD_CalculateCRC(frame, sizeof(apdu) + 1, &frame[sizeof(apdu) + 1]);
+        byte backLen = sizeof(frame);
+        byte status = mfrc522.PCD_TransceiveData(frame, sizeof(apdu) + 3, frame, &backLen, NULL, 0, true);
+        if (status != MFRC522::STATUS_OK) {
+            Serial.print("I-block: ");
+            Serial.println(mfrc522.GetStatusCodeName(status));
+            return 0;
+        }
+        pcb ^= 0x01;  // numero de bloc
+    }
+    return micros() - start;
+}
+
+void benchBitRate() {
+    Serial.println("\n--- Bench debit ISO 14443-4 ---");
+    byte rate;
+
+    // 1. RATS seul, on reste a 106 kbps
+    if (!selectTag()) return;
+    if (mfrc522.PICC_NegotiateBitRate(MFRC522::BITRATE_106, &rate) != MFRC522::STATUS_OK) return;
+    unsigned long slowUs = timeIBlocks();
+
+    // 2. Reinitialisation du champ, puis RATS + PPS au debit max du tag
+    mfrc522.PCD_AntennaOff();
+    delay(10);
+    mfrc522.PCD_AntennaOn();
+    delay(10);
+    if (!selectTag()) return;
+    if (mfrc522.PICC_NegotiateBitRate(MFRC522::BITRATE_848, &rate) != MFRC522::STATUS_OK) return;
+    unsigned long fastUs = timeIBlocks();
+    mfrc522.PCD_SetBitRate(MFRC522::BITRATE_106);
+
+    Serial.printf("106 kbps : %lu us / %d echanges\n", slowUs, BITRATE_EXCHANGES);
+    Serial.printf("%d kbps : %lu us / %d echanges\n", 106 << rate, fastUs, BITRATE_EXCHANGES);
+    if (slowUs && fastUs) Serial.printf("Gain : x%.2f\n", (float)slowUs / fastUs);
+
+    char line1[32];
+    char line2[32];
+    snprintf(line1, sizeof(line1), "106: %lu us", slowUs / BITRATE_EXCHANGES);
+    snprintf(line2, sizeof(line2), "%d: %lu us", 106 << rate, fastUs / BITRATE_EXCHANGES);
+    displayResult("Debit (par echange)", line1, line2);
+}
+
+void setup() {
+    M5.begin();
+    M5.Power.begin();
+    Serial.begin(115200);
+
+    Wire.begin(21, 22);
+    Wire.setClock(100000);
+
+    mfrc522.PCD_Init();
+    delay(100);
+    mfrc522.PCD_SetAntennaGain(mfrc522.RxGain_max);
+
+    byte version = mfrc522.PCD_ReadRegister(mfrc522.VersionReg);
+    Serial.printf("MFRC522 Version: 0x%02X\n", version);
+
+    M5.Lcd.fillScreen(BLACK);
+    M5.Lcd.setTextSize(2);
+    M5.Lcd.setCursor(10, 10);
+    M5.Lcd.setTextColor(CYAN);
+    M5.Lcd.println("=== RFID BENCH ===");
+    M5.Lcd.setTextColor(WHITE);
+    M5.Lcd.println("A: Inventaire");
+    M5.Lcd.println("B: Lecture NTAG");
+    M5.Lcd.println("C: Debit ISO-4");
+}
+
+void loop() {
+    M5.update();
+
+    if (M5.BtnA.wasPressed()) benchInventory();
+    if (M5.BtnB.wasPressed()) benchPageRead();
+    if (M5.BtnC.wasPressed()) benchBitRate();
+
+    delay(20);
+}